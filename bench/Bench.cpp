@@ -0,0 +1,529 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "../include/Electre.hpp"
+#include "../include/Json.hpp"
+#include "../include/Parser.hpp"
+#include "../include/Promethee.hpp"
+#include "../include/TaskScheduler.hpp"
+
+// ANSI escape codes for text color
+#define RESET "\033[0m"
+#define RED "\033[31m"
+#define GREEN "\033[32m"
+#define YELLOW "\033[33m"
+#define BLUE "\033[34m"
+
+struct BenchOptions
+{
+    std::vector<size_t> alternatives = {250, 1000};
+    std::vector<size_t> criteria = {4, 16};
+    std::vector<double> densities = {0.01, 0.05}; // Share of ordered pairs that pass the concordance threshold
+    std::vector<size_t> levels = {8, 0};         // Distinct values per criterion, 0 for continuous values
+    std::vector<size_t> scores = {0, 100};       // Electre: distinct integer values per criterion, 0 for continuous values
+    int warmup = 1;
+    int repeat = 10;
+    int threads = 1;
+    std::string filter = "";
+    std::string jsonFile = "";
+    std::string compareFile = "";
+};
+
+/**
+ * @brief Microbenchmarks of the parser and of every stage of Promethee and Electre.
+ *
+ *  Each benchmark rebuilds the state its stage starts from outside of the timed region, then times
+ *  the stage alone: a warmup, then the repetitions whose median and 95th percentile are reported.
+ *  Being a friend of the algorithms, it drives their private stages exactly as run() does.
+ */
+class Bench
+{
+public:
+    Bench(const BenchOptions &options) : options(options), scheduler(options.threads) {}
+
+    int run();
+
+private:
+    struct Result
+    {
+        std::string name;
+        size_t n;
+        size_t m;
+        double density;  // < 0 when the benchmark does not depend on it
+        long levels;     // < 0 when the benchmark does not depend on it
+        std::vector<double> samplesMs;
+        double medianMs;
+        double p95Ms;
+    };
+
+    BenchOptions options;
+    TaskScheduler scheduler;
+    std::ostream silent{nullptr};
+    std::vector<Result> results;
+
+    std::shared_ptr<Dataset> generate(size_t n, size_t m, size_t levels, unsigned seed);
+    float thresholdForDensity(const Dataset &dataset, double density);
+    void measure(const std::string &name, size_t n, size_t m, double density, long levels,
+                 const std::function<void()> &setup, const std::function<void()> &body);
+
+    void benchParser(size_t n, size_t m);
+    void benchPromethee(size_t n, size_t m, size_t levels);
+    void benchElectre(size_t n, size_t m, double density, size_t scores);
+
+    void print(const Result &result, const Json *baseline);
+    bool writeJson(const std::string &path);
+};
+
+/**
+ * @brief Generates a decision matrix with its parameters.
+ *
+ * @param n Number of alternatives.
+ * @param m Number of criteria.
+ * @param levels Distinct values per criterion, 0 for continuous values in [0, 100).
+ * @param seed Seed of the generator, so that every commit benchmarks the same data.
+ * @return The dataset, with a concordance threshold of 0 until thresholdForDensity() is applied.
+ */
+std::shared_ptr<Dataset> Bench::generate(size_t n, size_t m, size_t levels, unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> uniform(0, 100);
+    std::uniform_int_distribution<int> level(0, std::max<int>(levels, 1) - 1);
+
+    std::vector<float> values(n * m);
+    for (float &value : values)
+        value = levels == 0 ? uniform(generator) : level(generator) * 100.0f / levels;
+
+    std::vector<float> weights(m);
+    float totalWeight = 0;
+    for (float &weight : weights)
+        totalWeight += weight = 1 + uniform(generator) / 100;
+    for (float &weight : weights)
+        weight /= totalWeight;
+
+    std::vector<OptimizationType> optimizations(m);
+    for (size_t k = 0; k < m; k++)
+        optimizations[k] = k % 2 == 0 ? MAX : MIN;
+
+    auto dataset = std::make_shared<Dataset>();
+    dataset->setValues(n, m, std::move(values));
+    dataset->setWeights(weights);
+    dataset->setVetos(std::vector<float>(m, 60));
+    dataset->setPreferenceThresholds(std::vector<float>(m, 5));
+    dataset->setOptimizations(optimizations);
+    return dataset;
+}
+
+/**
+ * @brief Picks the concordance threshold that keeps the given share of the ordered pairs.
+ *
+ * @param dataset The generated dataset.
+ * @param density Share of ordered pairs whose concordance reaches the threshold.
+ * @return The threshold.
+ */
+float Bench::thresholdForDensity(const Dataset &dataset, double density)
+{
+    Electre electre;
+    electre.setOutput(silent);
+    electre.setDataset(std::make_shared<Dataset>(dataset));
+    electre.scheduler = &scheduler;
+    electre.resetMatrixes();
+    electre.processConcordance();
+
+    std::vector<float> values;
+    size_t n = dataset.getNbAlternatives();
+    values.reserve(n * (n - 1));
+    for (size_t y = 0; y < n; y++)
+    {
+        for (size_t x = 0; x < n; x++)
+        {
+            if (x != y)
+                values.push_back(electre.concordance[y][x]);
+        }
+    }
+    size_t rank = std::min(values.size() - 1, (size_t)((1 - density) * values.size()));
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+/**
+ * @brief Times a benchmark and records its result.
+ *
+ * @param setup Rebuilds the input state, not timed.
+ * @param body The timed code.
+ */
+void Bench::measure(const std::string &name, size_t n, size_t m, double density, long levels,
+                    const std::function<void()> &setup, const std::function<void()> &body)
+{
+    std::ostringstream label;
+    label << name << " n=" << n << " m=" << m;
+    if (density >= 0)
+        label << " density=" << density;
+    if (levels >= 0)
+        label << " levels=" << levels;
+    if (options.filter != "" && label.str().find(options.filter) == std::string::npos)
+        return;
+
+    Result result{name, n, m, density, levels, {}, 0, 0};
+    for (int i = 0; i < options.warmup + options.repeat; i++)
+    {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i >= options.warmup)
+            result.samplesMs.push_back(elapsed);
+    }
+
+    std::vector<double> sorted = result.samplesMs;
+    std::sort(sorted.begin(), sorted.end());
+    size_t count = sorted.size();
+    result.medianMs = count % 2 == 1 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+    result.p95Ms = sorted[std::max<size_t>(1, std::ceil(0.95 * count)) - 1];
+    results.push_back(result);
+}
+
+void Bench::benchParser(size_t n, size_t m)
+{
+    std::shared_ptr<Dataset> dataset = generate(n, m, 0, 1);
+    std::filesystem::path file = std::filesystem::temp_directory_path() / ("ams-bench-" + std::to_string(getpid()) + ".csv");
+    {
+        // One criterion per line, as Parser expects
+        std::ofstream csv(file);
+        for (size_t k = 0; k < m; k++)
+        {
+            for (size_t a = 0; a < n; a++)
+                csv << (a ? "," : "") << dataset->value(a, k);
+            csv << "\n";
+        }
+    }
+
+    measure("parser/parseFile", n, m, -1, -1, [] {}, [&]
+            {
+        Parser parser;
+        parser.setOutput(silent);
+        parser.parseFile(file.string()); });
+    std::filesystem::remove(file);
+}
+
+void Bench::benchPromethee(size_t n, size_t m, size_t levels)
+{
+    std::shared_ptr<Dataset> dataset = generate(n, m, levels, 2);
+    std::unique_ptr<Promethee> promethee;
+
+    // Brings a fresh Promethee to the start of the given stage, as run() would
+    auto prepare = [&](int stage)
+    {
+        promethee = std::make_unique<Promethee>();
+        promethee->setOutput(silent);
+        promethee->setDataset(dataset);
+        promethee->scheduler = &scheduler;
+        promethee->multicriteriaPreferenceMatrix.resize(n, std::vector<float>(n, -1));
+        promethee->planCriteria();
+        if (stage > 0)
+            promethee->calculatePreferenceMatrix();
+        if (stage > 1)
+            promethee->calculateFlows();
+    };
+
+    measure("promethee/calculatePreferenceMatrix", n, m, -1, levels, [&]
+            { prepare(0); }, [&]
+            { promethee->calculatePreferenceMatrix(); });
+    measure("promethee/calculateFlows", n, m, -1, levels, [&]
+            { prepare(1); }, [&]
+            { promethee->calculateFlows(); });
+
+    // The ranking only depends on n
+    if (m == options.criteria.front() && levels == options.levels.front())
+    {
+        measure("promethee/calculatePosition", n, m, -1, -1, [&]
+                { prepare(2); }, [&]
+                { promethee->calculatePosition(promethee->flows, MAX); });
+    }
+}
+
+void Bench::benchElectre(size_t n, size_t m, double density, size_t scores)
+{
+    std::shared_ptr<Dataset> dataset = generate(n, m, scores, 3);
+    dataset->setConcordanceThreshold(thresholdForDensity(*dataset, density));
+    std::unique_ptr<Electre> electre;
+
+    // Brings a fresh Electre to the start of the given stage, as runInMemory() would
+    auto prepare = [&](int stage)
+    {
+        electre = std::make_unique<Electre>();
+        electre->setOutput(silent);
+        electre->setDataset(dataset);
+        electre->scheduler = &scheduler;
+        electre->resetMatrixes();
+        if (stage > 0)
+            electre->processConcordance();
+        if (stage > 1)
+            electre->processNondiscordance();
+        if (stage > 2)
+            electre->processDominance();
+    };
+
+    // The matrix stages do not depend on the threshold, the graph stages do not read the values
+    if (density == options.densities.front())
+    {
+        measure("electre/processConcordance", n, m, -1, scores, [&]
+                { prepare(0); }, [&]
+                { electre->processConcordance(); });
+        measure("electre/processNondiscordance", n, m, -1, scores, [&]
+                { prepare(1); }, [&]
+                { electre->processNondiscordance(); });
+    }
+    if (scores != options.scores.front())
+        return;
+    measure("electre/processDominance", n, m, density, -1, [&]
+            { prepare(2); }, [&]
+            { electre->processDominance(); });
+    measure("electre/processKernel", n, m, density, -1, [&]
+            { prepare(3); }, [&]
+            { electre->processKernel(); });
+}
+
+/**
+ * @brief Prints one result, with its change from the baseline when there is one.
+ *
+ * @param result The result.
+ * @param baseline The results of a previous --json run, or nullptr.
+ */
+void Bench::print(const Result &result, const Json *baseline)
+{
+    std::ostringstream parameters;
+    parameters << "n=" << result.n << " m=" << result.m;
+    if (result.density >= 0)
+        parameters << " density=" << result.density;
+    if (result.levels >= 0)
+        parameters << " levels=" << result.levels;
+
+    std::cout << std::left << std::setw(38) << result.name << std::setw(32) << parameters.str() << std::right << std::fixed
+              << std::setprecision(3) << "median " << std::setw(10) << result.medianMs << " ms   p95 " << std::setw(10)
+              << result.p95Ms << " ms";
+
+    if (baseline)
+    {
+        for (const Json &entry : (*baseline)["benchmarks"].asArray())
+        {
+            if (entry["name"].asString() != result.name || entry["n"].asNumber() != result.n || entry["m"].asNumber() != result.m ||
+                entry["density"].asNumber() != result.density || entry["levels"].asNumber() != result.levels)
+                continue;
+            double change = (result.medianMs / entry["medianMs"].asNumber() - 1) * 100;
+            std::cout << "   " << (change > 5 ? RED : change < -5 ? GREEN : "") << std::showpos << std::setprecision(1) << change
+                      << "%" << std::noshowpos << RESET;
+            break;
+        }
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
+
+/**
+ * @brief Writes every result as JSON, to be given to --compare by a later run.
+ *
+ * @param path The output file.
+ * @return false if the file could not be written.
+ */
+bool Bench::writeJson(const std::string &path)
+{
+    Json benchmarks = Json::array();
+    for (const Result &result : results)
+    {
+        Json entry = Json::object();
+        entry["name"] = result.name;
+        entry["n"] = result.n;
+        entry["m"] = result.m;
+        entry["density"] = result.density;
+        entry["levels"] = (int)result.levels;
+        entry["medianMs"] = result.medianMs;
+        entry["p95Ms"] = result.p95Ms;
+        entry["samplesMs"] = Json::array(result.samplesMs);
+        benchmarks.push(entry);
+    }
+
+    Json report = Json::object();
+    report["threads"] = scheduler.getThreadCount();
+    report["warmup"] = options.warmup;
+    report["repeat"] = options.repeat;
+    report["benchmarks"] = benchmarks;
+
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Error: " << path << std::endl;
+        return false;
+    }
+    file << report.dump() << "\n";
+    return true;
+}
+
+int Bench::run()
+{
+    std::unique_ptr<Json> baseline;
+    if (options.compareFile != "")
+    {
+        std::ifstream file(options.compareFile);
+        std::stringstream text;
+        text << file.rdbuf();
+        try
+        {
+            baseline = std::make_unique<Json>(Json::parse(text.str()));
+        }
+        catch (const std::exception &exception)
+        {
+            std::cerr << "Error: " << options.compareFile << ": " << exception.what() << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << GREEN << "========== Benchmarks (" << options.warmup << " warmup, " << options.repeat << " repetitions, "
+              << scheduler.getThreadCount() << " threads) ==========" << RESET << std::endl;
+
+    size_t printed = 0;
+    auto flush = [&]
+    {
+        for (; printed < results.size(); printed++)
+            print(results[printed], baseline.get());
+    };
+
+    std::cout << BLUE << "[Parser]" << RESET << std::endl;
+    for (size_t n : options.alternatives)
+    {
+        for (size_t m : options.criteria)
+        {
+            benchParser(n, m);
+            flush();
+        }
+    }
+
+    std::cout << BLUE << "[Promethee]" << RESET << std::endl;
+    for (size_t n : options.alternatives)
+    {
+        for (size_t m : options.criteria)
+        {
+            for (size_t levels : options.levels)
+            {
+                benchPromethee(n, m, levels);
+                flush();
+            }
+        }
+    }
+
+    std::cout << BLUE << "[Electre]" << RESET << std::endl;
+    for (size_t n : options.alternatives)
+    {
+        for (size_t m : options.criteria)
+        {
+            for (double density : options.densities)
+            {
+                for (size_t scores : options.scores)
+                {
+                    benchElectre(n, m, density, scores);
+                    flush();
+                }
+            }
+        }
+    }
+
+    if (options.jsonFile != "" && !writeJson(options.jsonFile))
+        return 1;
+    std::cout << GREEN << "========== " << results.size() << " benchmarks done ==========" << RESET << std::endl;
+    return 0;
+}
+
+template <typename T>
+std::vector<T> parse_list(const std::string &text)
+{
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        T value;
+        std::istringstream(item) >> value;
+        values.push_back(value);
+    }
+    return values;
+}
+
+void print_usage()
+{
+    std::cout << "\033[1mUsage: \033[0mams-bench [options]" << std::endl
+              << "          -h | --help                     Help" << std::endl
+              << "               --n                        Numbers of alternatives (default 250,1000)" << std::endl
+              << "               --m                        Numbers of criteria (default 4,16)" << std::endl
+              << "               --density                  Electre: shares of pairs passing the concordance threshold (default 0.01,0.05)" << std::endl
+              << "               --levels                   Promethee: distinct values per criterion, 0 for continuous (default 8,0)" << std::endl
+              << "               --scores                   Electre: distinct integer values per criterion, 0 for continuous (default 0,100)" << std::endl
+              << "               --warmup                   Untimed runs before the repetitions (default 1)" << std::endl
+              << "               --repeat                   Timed repetitions (default 10)" << std::endl
+              << "               --threads                  Threads of the scheduler (default 1)" << std::endl
+              << "               --filter                   Only run the benchmarks whose label contains this text" << std::endl
+              << "               --json                     Write the results to this JSON file" << std::endl
+              << "               --compare                  Print the change of each median from this JSON file" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help"))
+        {
+            print_usage();
+            return 0;
+        }
+        else if (!strcmp(argv[i], "--n") && hasValue)
+            options.alternatives = parse_list<size_t>(argv[++i]);
+        else if (!strcmp(argv[i], "--m") && hasValue)
+            options.criteria = parse_list<size_t>(argv[++i]);
+        else if (!strcmp(argv[i], "--density") && hasValue)
+            options.densities = parse_list<double>(argv[++i]);
+        else if (!strcmp(argv[i], "--levels") && hasValue)
+            options.levels = parse_list<size_t>(argv[++i]);
+        else if (!strcmp(argv[i], "--scores") && hasValue)
+            options.scores = parse_list<size_t>(argv[++i]);
+        else if (!strcmp(argv[i], "--warmup") && hasValue)
+            options.warmup = std::stoi(argv[++i]);
+        else if (!strcmp(argv[i], "--repeat") && hasValue)
+            options.repeat = std::stoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && hasValue)
+            options.threads = std::stoi(argv[++i]);
+        else if (!strcmp(argv[i], "--filter") && hasValue)
+            options.filter = argv[++i];
+        else if (!strcmp(argv[i], "--json") && hasValue)
+            options.jsonFile = argv[++i];
+        else if (!strcmp(argv[i], "--compare") && hasValue)
+            options.compareFile = argv[++i];
+        else
+        {
+            print_usage();
+            std::cerr << "Error: unknown or incomplete argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.alternatives.empty() || options.criteria.empty() || options.densities.empty() || options.levels.empty() ||
+        options.scores.empty() ||
+        options.repeat < 1 || options.warmup < 0 || options.threads < 1)
+    {
+        std::cerr << "Error: every list needs a value, --repeat and --threads must be at least 1" << std::endl;
+        return 1;
+    }
+
+    Bench bench(options);
+    return bench.run();
+}
@@ -3,25 +3,62 @@
 
 #include <string>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
 #include <vector>
+#include "Dataset.hpp"
+#include "OutputFormat.hpp"
+#include "TaskScheduler.hpp"
 
 class Algo
 {
 public:
-    std::string getName() { return this->name; };
-    std::string getArgName() { return this->argName; };
-    std::string getDescription() { return this->description; };
-    std::string getAltInfo() { return this->altInfo; };
+    std::string getName() const { return this->name; };
+    std::string getArgName() const { return this->argName; };
+    std::string getDescription() const { return this->description; };
+    std::string getAltInfo() const { return this->altInfo; };
+    std::shared_ptr<const Dataset> getDataset() const { return dataset; }
+    OutputFormat getOutputFormat() const { return outputFormat; }
 
-    virtual void setData(const std::vector<std::vector<float>> &newData) { data = newData; }
-    virtual void setWeights(const std::vector<float> &newWeights) { weights = newWeights; }
+    // The dataset is borrowed, never copied
+    virtual void setDataset(std::shared_ptr<const Dataset> newDataset)
+    {
+        dataset = std::move(newDataset);
+        weights = dataset->getWeights();
+    }
+    virtual void setData(const std::vector<std::vector<float>> &newData)
+    {
+        auto copy = Dataset::fromRows(newData);
+        copy->setWeights(std::vector<float>(weights.begin(), weights.end()));
+        setDataset(copy);
+    }
+    virtual void setWeights(const std::vector<float> &newWeights)
+    {
+        auto copy = cloneDataset();
+        copy->setWeights(newWeights);
+        setDataset(copy);
+    }
+    void setVerbose(bool newVerbose) { verbose = newVerbose; }
+    // Where the progress and results are printed, std::cout by default
+    void setOutput(std::ostream &newOutput) { output = &newOutput; }
+    void setOutputFormat(OutputFormat newFormat) { outputFormat = newFormat; }
 
     explicit Algo(const std::string &name, const std::string &argName, const std::string &description, const std::string &altInfo)
-        : name(name), argName(argName), description(description), altInfo(altInfo) {}
+        : name(name), argName(argName), description(description), altInfo(altInfo), dataset(std::make_shared<const Dataset>()) {}
 
-    // Pure virtual function to be implemented by subclasses
-    virtual void run() { std::cout << "Pure virtual function, must be implemented by subclasses" << std::endl; };
+    // Pure virtual function to be implemented by subclasses, the scheduler is shared by the whole process.
+    // Returns false if the algorithm failed, its results must then be neither saved nor cached
+    virtual bool run(TaskScheduler &)
+    {
+        std::cout << "Pure virtual function, must be implemented by subclasses" << std::endl;
+        return false;
+    };
     virtual int save(std::string dirPath);
+    // One line describing the result of the last run, empty if there is nothing to report
+    virtual std::string summary() { return ""; }
+    // Options that change what save() writes, nothing if the results of this configuration cannot be reused
+    virtual std::optional<std::string> cacheConfiguration() const { return ""; }
 
 protected:
     std::string name;
@@ -29,8 +66,25 @@ protected:
     std::string description;
     std::string altInfo;
 
-    std::vector<std::vector<float>> data;
-    std::vector<float> weights;
+    std::shared_ptr<const Dataset> dataset;
+    std::span<const float> weights; // View over dataset->getWeights()
+    bool verbose = false;
+    std::ostream *output = &std::cout;
+    OutputFormat outputFormat = CSV;
+    TaskScheduler *scheduler = nullptr; // Set by run(), the stages run sequentially without it
+
+    // Copy of the dataset sharing its values, to change one of its parameters
+    std::shared_ptr<Dataset> cloneDataset() const { return std::make_shared<Dataset>(*dataset); }
+    float value(size_t alternative, size_t criterium) const { return dataset->value(alternative, criterium); }
+    size_t nbAlternatives() const { return dataset->getNbAlternatives(); }
+    std::ostream &log() const { return *output; }
+    void parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)> &body, size_t grain = 0) const
+    {
+        if (scheduler)
+            scheduler->parallelFor(begin, end, grain, body);
+        else if (begin < end)
+            body(begin, end);
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
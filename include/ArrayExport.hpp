@@ -0,0 +1,50 @@
+#ifndef ARRAY_EXPORT_HPP
+#define ARRAY_EXPORT_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+#include "Json.hpp"
+#include "OutputFormat.hpp"
+#include "TaskScheduler.hpp"
+
+/**
+ * @brief Writes the arrays of Algo::save as .npy or raw binaries, listed in a manifest.json.
+ *
+ * A contiguous array is written with a single writev(2) of its header and data. An array stored
+ * row by row (the n×n matrixes) is written through a shared mapping of the output file, its rows
+ * copied or packed in parallel, so that saving is bound by the disk rather than by formatting.
+ *
+ * Raw files hold the data alone, starting at offset 0 so they can be mapped as is; .npy files
+ * start with a version 1.0 header padded to 64 bytes. The manifest gives, for every array, its
+ * file, dtype, shape and data offset.
+ */
+class ArrayExport
+{
+public:
+    ArrayExport(const std::filesystem::path &directory, OutputFormat format, TaskScheduler *scheduler = nullptr)
+        : directory(directory), format(format), scheduler(scheduler), arrays(Json::array()) {}
+
+    bool add(const std::string &name, std::span<const float> values);
+    bool add(const std::string &name, std::span<const int> values);
+    bool add(const std::string &name, const std::vector<bool> &values);
+    bool addRows(const std::string &name, const char *dtype, std::vector<size_t> shape, size_t rowBytes,
+                 const std::function<void(size_t row, uint8_t *destination)> &fillRow, Json details = Json::object());
+    bool writeManifest(const std::string &algorithm);
+
+private:
+    std::filesystem::path directory;
+    OutputFormat format;
+    TaskScheduler *scheduler;
+    Json arrays;
+
+    std::string header(const char *dtype, const std::vector<size_t> &shape) const;
+    std::filesystem::path fileOf(const std::string &name) const;
+    bool addContiguous(const std::string &name, const char *dtype, std::vector<size_t> shape, const void *data, size_t bytes);
+    void record(const std::string &name, const char *dtype, const std::vector<size_t> &shape, size_t offset, Json details);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Algo.hpp"
+#include "TaskScheduler.hpp"
+
+/**
+ * @brief Options applied to every job of a batch, as given on the command line.
+ */
+struct BatchOptions
+{
+    std::string algorithms = "ep";
+    std::string outputRoot; // Empty to only print the summaries
+    bool verbose = false;
+    bool useSkyline = false;
+    size_t memoryLimit = 0;
+    std::string scratchDirectory;
+    bool useStreaming = false;
+    bool useApproximation = false;
+    double deadlineMs = 100;
+    double epsilon = 0;
+    int topK = 10;
+    OutputFormat format = CSV;
+};
+
+/**
+ * @brief Runs the algorithms on every dataset directory below a root, in a single process.
+ *
+ * A directory is a dataset when it holds a `donnees.csv`; its `weight.csv` (or `poids.csv`),
+ * `vetos.csv`, `optimizations.csv`, `preferences.csv` and `seuilconcordance.csv` are used when
+ * present. A discovery thread feeds a bounded queue drained by one task per scheduler thread,
+ * each job writes its results under the same relative path of the output root, and a one-line
+ * summary is printed as soon as a job completes.
+ */
+class Batch
+{
+public:
+    Batch(const std::filesystem::path &root, const BatchOptions &options) : root(root), options(options) {}
+
+    int run(TaskScheduler &scheduler);
+
+private:
+    struct Job
+    {
+        int index;
+        std::filesystem::path directory;
+    };
+
+    std::filesystem::path root;
+    BatchOptions options;
+    std::mutex consoleMutex;
+
+    bool runJob(const Job &job, TaskScheduler &scheduler);
+};
+
+#endif
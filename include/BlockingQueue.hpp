@@ -0,0 +1,63 @@
+#ifndef BLOCKING_QUEUE_HPP
+#define BLOCKING_QUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+/**
+ * @brief Bounded multi-producer multi-consumer queue.
+ *
+ * push() blocks while the queue is full, pop() blocks while it is empty and returns nothing
+ * once the queue is closed and drained.
+ */
+template <typename T>
+class BlockingQueue
+{
+public:
+    explicit BlockingQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity || closed; });
+        if (closed)
+            return;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
+            return std::nullopt;
+        T item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    // No more items will be pushed, waiting consumers are released once the queue is empty
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+private:
+    size_t capacity;
+    bool closed = false;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef CRITERION_KERNELS_HPP
+#define CRITERION_KERNELS_HPP
+
+#include <array>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Pairwise kernels specialised on the number of criteria.
+ *
+ * The criterion loop of the O(n²) stages runs once per pair with a count known only at run time.
+ * A kernel written as a member template `kernel<M>` gets M criteria as a constant, which lets the
+ * compiler fully unroll that loop and keep the per-criterion parameters in registers; M = 0 is the
+ * generic instantiation reading the count at run time. criterionKernelTable() instantiates every
+ * M up to MAX_SPECIALISED_CRITERIA once, and selectCriterionKernel() picks the one for a dataset.
+ */
+
+// Criterion counts with their own instantiation, larger counts use the generic kernel
+constexpr int MAX_SPECIALISED_CRITERIA = 64;
+
+/**
+ * @brief Per-criterion parameters of a kernel: a fixed-size array when M is known, a vector for
+ * the generic kernel.
+ */
+template <typename T, int M>
+struct CriterionArray
+{
+    std::array<T, M> items{};
+
+    explicit CriterionArray(int) {}
+    T &operator[](int criterium) { return items[criterium]; }
+    const T &operator[](int criterium) const { return items[criterium]; }
+};
+
+template <typename T>
+struct CriterionArray<T, 0>
+{
+    std::vector<T> items;
+
+    explicit CriterionArray(int count) : items(count) {}
+    T &operator[](int criterium) { return items[criterium]; }
+    const T &operator[](int criterium) const { return items[criterium]; }
+};
+
+template <typename Instance, int... Ms>
+constexpr auto criterionKernelTable(Instance instance, std::integer_sequence<int, Ms...>)
+{
+    return std::array{instance.template operator()<Ms>()...};
+}
+
+/**
+ * @brief Instantiates a kernel for 0 (generic) to MAX_SPECIALISED_CRITERIA criteria.
+ *
+ * @param instance A generic lambda returning one instantiation, e.g.
+ * `[]<int M>() { return &Electre::concordanceRows<M>; }`, written inside the class so that it may
+ * name private kernels.
+ * @return The instantiations, indexed by their criterion count.
+ */
+template <typename Instance>
+constexpr auto criterionKernelTable(Instance instance)
+{
+    return criterionKernelTable(instance, std::make_integer_sequence<int, MAX_SPECIALISED_CRITERIA + 1>());
+}
+
+template <typename Kernel, size_t N>
+Kernel selectCriterionKernel(const std::array<Kernel, N> &table, int criteria)
+{
+    return criteria > 0 && (size_t)criteria < N ? table[criteria] : table[0];
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef CSV_WRITER_HPP
+#define CSV_WRITER_HPP
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "TaskScheduler.hpp"
+
+/**
+ * @brief Buffered writer of the CSV outputs of Algo::save.
+ *
+ * Values are formatted with std::to_chars into a large buffer that is handed to write(2) in one
+ * call once full. Floats use the same "%g" formatting as std::ostream's default, so the files
+ * are byte-identical to those written with operator<<.
+ *
+ * writeRows() formats blocks of rows in parallel on the scheduler and writes them in order, for
+ * the n×n outputs.
+ */
+class CsvWriter
+{
+public:
+    explicit CsvWriter(const std::filesystem::path &path);
+    ~CsvWriter();
+    CsvWriter(const CsvWriter &) = delete;
+    CsvWriter &operator=(const CsvWriter &) = delete;
+
+    explicit operator bool() const { return fd >= 0 && !failed; }
+
+    CsvWriter &operator<<(float value)
+    {
+        append(buffer, value);
+        return flushIfFull();
+    }
+    CsvWriter &operator<<(int value)
+    {
+        append(buffer, value);
+        return flushIfFull();
+    }
+    CsvWriter &operator<<(bool value)
+    {
+        buffer += value ? '1' : '0';
+        return flushIfFull();
+    }
+    CsvWriter &operator<<(char value)
+    {
+        buffer += value;
+        return flushIfFull();
+    }
+    CsvWriter &operator<<(std::string_view text)
+    {
+        buffer += text;
+        return flushIfFull();
+    }
+    // Otherwise string literals would pick the bool overload
+    CsvWriter &operator<<(const char *text) { return *this << std::string_view(text); }
+
+    void writeRows(size_t rowCount, const std::function<void(size_t row, std::string &out)> &formatRow, TaskScheduler *scheduler = nullptr);
+    bool close();
+
+    static void append(std::string &out, float value);
+    static void append(std::string &out, int value);
+
+    // Bytes buffered before a write(2), and formatted per task by writeRows()
+    static constexpr size_t BUFFER_BYTES = 1 << 20;
+
+private:
+    int fd = -1;
+    bool failed = false;
+    std::string buffer;
+
+    CsvWriter &flushIfFull()
+    {
+        if (buffer.size() >= BUFFER_BYTES)
+            flush();
+        return *this;
+    }
+    void flush();
+    void writeAll(std::string_view bytes);
+};
+
+#endif
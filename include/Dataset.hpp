@@ -0,0 +1,124 @@
+#ifndef DATASET_HPP
+#define DATASET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "OptimizationType.hpp"
+
+/**
+ * @brief One level of the criteria hierarchy of label.json, e.g. the themes.
+ */
+struct CriterionLevel
+{
+    std::string label;               // e.g. "Thèmes"
+    std::vector<std::string> groups; // Names of the groups of this level, in file order
+    std::vector<int> groupOf;        // Group of each criterion
+};
+
+// Narrowest storage holding every value of a column exactly, as an offset from its minimum. There is
+// no half-precision tier: fp16 holds integers exactly only up to 2048, which 16 bits already cover
+// with exact integer arithmetic, and it would round fractions, changing the threshold decisions.
+enum ColumnStorage
+{
+    STORAGE_UINT8,
+    STORAGE_UINT16,
+    STORAGE_FP32
+};
+
+/**
+ * @brief Storage chosen for a column when the values are set.
+ *
+ * A column of integers whose range fits in 8 or 16 bits is kept only at that width, as
+ * `value − minimum`, which keeps every comparison and every difference exact while moving 2 to 4
+ * times fewer bytes than floats. Any other column is kept as floats.
+ */
+struct ColumnEncoding
+{
+    ColumnStorage storage = STORAGE_FP32;
+    float minimum = 0;
+    float maximum = 0;
+    size_t offset = 0; // Of the column in the storage buffer, in bytes
+};
+
+/**
+ * @brief Decision matrix and per-criterion parameters shared by all the algorithms.
+ *
+ * The values are stored once, criterion by criterion (the layout of the data files), each column
+ * at its own width, behind a reference-counted buffer: copying a Dataset to change a parameter
+ * never copies the values. Readers decode single values with value(), or expand a whole column to
+ * floats with expandColumn(); the Electre kernels read the columns at their width.
+ * The Parser builds a Dataset and every Algo borrows it as a `std::shared_ptr<const Dataset>`.
+ */
+class Dataset
+{
+public:
+    Dataset() = default;
+
+    static std::shared_ptr<Dataset> fromRows(const std::vector<std::vector<float>> &rows);
+    std::shared_ptr<Dataset> subset(const std::vector<int> &alternatives) const;
+    std::vector<std::vector<float>> toRows() const;
+
+    size_t getNbAlternatives() const { return nbAlternatives; }
+    size_t getNbCriteria() const { return nbCriteria; }
+    float value(size_t alternative, size_t criterium) const
+    {
+        const ColumnEncoding &encoding = encodings[criterium];
+        const std::byte *cells = storage->data() + encoding.offset;
+        switch (encoding.storage)
+        {
+        case STORAGE_UINT8:
+            return encoding.minimum + reinterpret_cast<const uint8_t *>(cells)[alternative];
+        case STORAGE_UINT16:
+            return encoding.minimum + reinterpret_cast<const uint16_t *>(cells)[alternative];
+        default:
+            return reinterpret_cast<const float *>(cells)[alternative];
+        }
+    }
+    std::vector<float> expandColumn(size_t criterium) const;
+    const ColumnEncoding &encoding(size_t criterium) const { return encodings[criterium]; }
+    // The cells of a column at the width of its storage: value − minimum for the integer ones
+    const std::byte *columnData(size_t criterium) const { return storage->data() + encodings[criterium].offset; }
+    size_t getStorageBytes() const { return storage ? storage->size() : 0; }
+    // Owner of the values, shared by every copy of the dataset
+    const std::shared_ptr<const std::vector<std::byte>> &getStorage() const { return storage; }
+
+    std::span<const float> getWeights() const { return weights; }
+    std::span<const float> getVetos() const { return vetos; }
+    std::span<const float> getPreferenceThresholds() const { return preferenceThresholds; }
+    std::span<const OptimizationType> getOptimizations() const { return optimizations; }
+    float getConcordanceThreshold() const { return concordanceThreshold; }
+    std::span<const size_t> getCriterionCardinalities() const { return criterionCardinalities; }
+    // Levels above the criteria, coarsest first, empty without label.json
+    std::span<const CriterionLevel> getHierarchy() const { return hierarchy; }
+
+    void setValues(size_t newNbAlternatives, size_t newNbCriteria, std::vector<float> criterionMajorValues);
+    void setWeights(const std::vector<float> &newWeights) { weights = newWeights; }
+    void setVetos(const std::vector<float> &newVetos) { vetos = newVetos; }
+    void setPreferenceThresholds(const std::vector<float> &newThresholds) { preferenceThresholds = newThresholds; }
+    void setOptimizations(const std::vector<OptimizationType> &newOptimizations) { optimizations = newOptimizations; }
+    void setConcordanceThreshold(float newThreshold) { concordanceThreshold = newThreshold; }
+    void setCriterionCardinalities(const std::vector<size_t> &newCardinalities) { criterionCardinalities = newCardinalities; }
+    void setHierarchy(const std::vector<CriterionLevel> &newHierarchy) { hierarchy = newHierarchy; }
+
+private:
+    size_t nbAlternatives = 0;
+    size_t nbCriteria = 0;
+    std::shared_ptr<const std::vector<std::byte>> storage; // Every column at its own width, shared between copies
+    std::vector<ColumnEncoding> encodings;                 // One per criterion, see encodeColumns()
+
+    std::vector<float> weights;
+    std::vector<float> vetos;
+    std::vector<float> preferenceThresholds;
+    std::vector<OptimizationType> optimizations;
+    float concordanceThreshold = 0;
+    std::vector<size_t> criterionCardinalities;
+    std::vector<CriterionLevel> hierarchy;
+
+    void encodeColumns(const std::vector<float> &criterionMajorValues);
+};
+
+#endif
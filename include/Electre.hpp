@@ -4,59 +4,128 @@
 #include <vector>
 #include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 #include "OptimizationType.hpp"
 #include "Algo.hpp"
+#include "TileStore.hpp"
 
 class Electre : public Algo
 {
+    // The microbenchmarks in bench/ time the private stages one by one
+    friend class Bench;
+
 private:
-    std::vector<std::vector<float>> values;
-    std::vector<float> vetos;
-    std::vector<float> preferenceThresholds;
-    std::vector<OptimizationType> optimizations;
-    float concordanceThreshold;
+    // Views over the borrowed dataset, refreshed by setDataset()
+    std::span<const float> vetos;
+    std::span<const float> preferenceThresholds;
+    std::span<const OptimizationType> optimizations;
+    float concordanceThreshold = 0;
+
+    int nbCandidates = 0;
+    int nbCriteria = 0;
 
-    int nbCandidates;
-    int nbCriteria;
+    // Columns where higher is always better, each read at the width of its own storage: MIN criteria
+    // are negated floats, or maximum − value in the integer storages. The MAX columns are read
+    // from the dataset, only the MIN ones are copied, by orientValues() when the values or the
+    // optimizations changed since the last call.
+    std::vector<ColumnStorage> orientedStorages;
+    std::vector<const std::byte *> orientedColumns;
+    std::vector<std::byte> orientedCopies;
+    std::shared_ptr<const Dataset> orientedSource; // Keeps the columns read in place alive
+    std::vector<OptimizationType> orientedOptimizations;
+    template <typename T>
+    const T *orientedColumn(int criterium) const { return reinterpret_cast<const T *>(orientedColumns[criterium]); }
+    float oriented(int candidate, int criterium) const
+    {
+        switch (orientedStorages[criterium])
+        {
+        case STORAGE_UINT8:
+            return orientedColumn<uint8_t>(criterium)[candidate];
+        case STORAGE_UINT16:
+            return orientedColumn<uint16_t>(criterium)[candidate];
+        default:
+            return orientedColumn<float>(criterium)[candidate];
+        }
+    }
 
     std::vector<std::vector<float>> concordance;
     std::vector<std::vector<bool>> nonDiscordance;
     std::vector<bool> kernel;
     std::vector<std::vector<bool>> dominance;
 
+    bool skylinePrefilter = false;
+    std::vector<int> skylineCandidates; // Original indexes of the alternatives kept by the skyline pre-pass
+    std::vector<int> cycleSearchOrder;  // Starting candidates of the cycle search, empty for index order
+
+    // Compressed sparse row copy of the dominance graph, only built when the relation is sparse
+    bool useSparseGraph = false;
+    std::vector<int> successorOffsets;
+    std::vector<int> successors;
+    std::vector<bool> successorAlive;
+
+    size_t memoryLimit = 0;             // Bytes, 0 means no limit
+    std::filesystem::path scratchDirectory = std::filesystem::temp_directory_path();
+
+    void orientValues();
     void processConcordance();
     void processNondiscordance();
+    void concordanceRows(size_t first, size_t last);
+    template <typename T>
+    void concordanceCriterion(int criterium, int y, const double *coefficients, float *over, float *under);
+    void nonDiscordanceRows(size_t first, size_t last);
+    template <typename T>
+    void nonDiscordanceCriterion(int criterium, int y, uint8_t *vetoed);
     void processDominance();
     void processKernel();
-    std::vector<std::vector<int>> getCycles();
-    std::vector<std::vector<int>> getSuccessorCycles(int candidate, std::vector<int> visitedChilds);
-    bool hasSameElements(std::vector<int> vec1, std::vector<int> vec2);
-    void deleteCycles(std::vector<std::vector<int>> cycles);
+    // Temporaries of the graph stage, allocated from the arena of processKernel()
+    using Path = std::pmr::vector<int>;
+    using Cycles = std::pmr::vector<Path>;
+    Cycles getCycles(std::pmr::memory_resource *arena);
+    void getSuccessorCycles(int candidate, Path &path, Cycles &cycles);
+    void addCycle(std::span<const int> cycle, Cycles &cycles);
+    bool hasSameElements(std::span<const int> vec1, std::span<const int> vec2);
+    void deleteCycles(const Cycles &cycles);
+    void deleteLink(int start, int end);
+    bool paretoDominates(int candidate1, int candidate2);
+    bool canUseSkyline();
+    std::vector<int> computeSkyline();
+    bool prunedOutrankNone(const std::vector<int> &skyline);
+    float pairConcordance(int candidate1, int candidate2);
+    bool pairNonDiscordance(int candidate1, int candidate2);
+    size_t inMemoryFootprint();
+    void resetMatrixes();
+    void runInMemory();
+    bool runOutOfCore(size_t retainedBytes);
+    bool coreSearchOrder(const TileStore &store, const std::vector<bool> &inCore, const std::vector<bool> &upstream,
+                         size_t used, std::vector<int> &order);
+    int saveArrays(const std::filesystem::path &folderPath);
 
 public:
     Electre(
-        std::vector<std::vector<float>> values,
-        std::vector<float> weights,
-        std::vector<float> vetos,
-        std::vector<OptimizationType> optimizations,
+        const std::vector<std::vector<float>> &values,
+        const std::vector<float> &weights,
+        const std::vector<float> &vetos,
+        const std::vector<OptimizationType> &optimizations,
         float concordanceThreshold);
 
     Electre(
-        std::vector<std::vector<float>> values,
-        std::vector<float> weights,
-        std::vector<float> vetos,
-        std::vector<float> preferenceThresholds,
-        std::vector<OptimizationType> optimizations,
+        const std::vector<std::vector<float>> &values,
+        const std::vector<float> &weights,
+        const std::vector<float> &vetos,
+        const std::vector<float> &preferenceThresholds,
+        const std::vector<OptimizationType> &optimizations,
         float concordanceThreshold);
 
     Electre() : Algo("Electre", "e", "For Electre algo", "in development") {};
 
     // Setters
-    void setData(const std::vector<std::vector<float>> &newData) override { values = newData; nbCandidates = values.size();}
-    void setWeights(const std::vector<float> &newWeights) override { weights = newWeights;  nbCriteria = weights.size();}
+    void setDataset(std::shared_ptr<const Dataset> newDataset) override;
     void setVetos(const std::vector<float> &newVetos);
     void setPreferenceThresholds(const std::vector<float> &newThresholds);
     void setOptimizations(const std::vector<OptimizationType> &newOptimizations);
@@ -64,12 +133,23 @@ public:
     void setConcordanceMatrix(const std::vector<std::vector<float>> &newConcordance);
     void setNonDiscordanceMatrix(const std::vector<std::vector<bool>> &newNonDiscordance);
     void setDominanceMatrix(const std::vector<std::vector<bool>> &newDominance);
+    bool isSparseGraph() { return useSparseGraph; }
     void setKernel(const std::vector<bool> &newKernel);
+    void setSkylinePrefilter(bool enabled) { skylinePrefilter = enabled; }
+    void setMemoryLimit(size_t bytes) { memoryLimit = bytes; }
+    void setScratchDirectory(const std::filesystem::path &directory) { scratchDirectory = directory; }
+
+    // Trimming passes over the tiles before the remaining candidates are treated as the cyclic core
+    static constexpr int MAX_TRIM_ROUNDS = 64;
+    // Above this ratio of edges over n(n-1), the graph stages keep scanning the dominance matrix rows
+    static constexpr double SPARSE_GRAPH_DENSITY = 0.1;
 
     void processMatrixes();
     std::vector<bool> getKernel();
     void printVectors();
-    void run() override;
+    bool run(TaskScheduler &taskScheduler) override;
+    std::string summary() override;
+    std::optional<std::string> cacheConfiguration() const override;
     virtual int save(std::string dirPath) override;
 };
 
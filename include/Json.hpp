@@ -0,0 +1,78 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Minimal JSON value, enough for the request and response documents of ams-BI.
+ *
+ * Objects keep their members in insertion order. parse() throws std::runtime_error on malformed
+ * input, and the accessors throw it when the value does not have the requested type.
+ */
+class Json
+{
+public:
+    enum Type
+    {
+        NUL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    Json() = default;
+    Json(bool value) : type(BOOLEAN), boolean(value) {}
+    Json(int value) : type(NUMBER), number(value) {}
+    Json(size_t value) : type(NUMBER), number(value) {}
+    Json(double value) : type(NUMBER), number(value) {}
+    Json(float value) : type(NUMBER), number(value), isFloat(true) {}
+    Json(const char *value) : type(STRING), string(value) {}
+    Json(const std::string &value) : type(STRING), string(value) {}
+
+    static Json array() { return Json(ARRAY); }
+    static Json object() { return Json(OBJECT); }
+    template <typename T>
+    static Json array(const std::vector<T> &values)
+    {
+        Json result = array();
+        for (const T &value : values)
+            result.push(Json(value));
+        return result;
+    }
+
+    static Json parse(const std::string &text);
+    std::string dump() const;
+
+    Type getType() const { return type; }
+    bool isNull() const { return type == NUL; }
+    bool asBool() const;
+    double asNumber() const;
+    const std::string &asString() const;
+    const std::vector<Json> &asArray() const;
+    const std::vector<std::pair<std::string, Json>> &asObject() const;
+    std::vector<float> asFloats() const;
+
+    bool contains(const std::string &key) const;
+    const Json &operator[](const std::string &key) const;
+    Json &operator[](const std::string &key);
+    void push(Json value);
+
+private:
+    explicit Json(Type type) : type(type) {}
+
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0;
+    bool isFloat = false; // Printed with the shortest float representation
+    std::string string;
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> members;
+
+    void dump(std::string &out) const;
+};
+
+#endif
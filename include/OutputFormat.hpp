@@ -0,0 +1,12 @@
+#ifndef OUTPUT_FORMAT
+#define OUTPUT_FORMAT
+
+// Files written by Algo::save
+enum OutputFormat
+{
+    CSV, // Text files, the historical outputs
+    NPY, // One NumPy .npy file per array, with a manifest.json
+    RAW  // One headerless little-endian binary per array, with a manifest.json
+};
+
+#endif
@@ -1,9 +1,14 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 #include "OptimizationType.hpp"
+#include "Dataset.hpp"
 
 class Parser
 {
@@ -11,6 +16,9 @@ public:
     Parser(char delimiter = ',');
     std::vector<float> split(const std::string &s);
     std::vector<OptimizationType> splitOptimization(const std::string &s);
+    static size_t countLevels(std::span<const float> line);
+    // Where the progress is printed, std::cout by default
+    void setOutput(std::ostream &newOutput) { output = &newOutput; }
 
     void parseFile(const std::string &filename);
     void parseWeightFile(const std::string &filename);
@@ -18,6 +26,8 @@ public:
     void parsePreferencesFile(const std::string &filename);
     void parseOptimizationsFile(const std::string &filename);
     void parseConcordanceThresholdFile(const std::string &filename);
+    void parseHierarchyFile(const std::string &filename);
+    void parseDirectory(const std::filesystem::path &directory, bool withData = true);
 
     void print() const;
     std::vector<std::vector<float>> getParsedFile();
@@ -26,15 +36,18 @@ public:
     std::vector<float> getParsedPreferencesFile();
     std::vector<OptimizationType> getParsedOptimizationsFile();
     float getParsedConcordanceThresholdFile();
+    std::vector<size_t> getParsedCriterionCardinalities();
+    std::shared_ptr<const Dataset> getDataset();
+
+    // Distinct values tracked per criterion before it is considered high-cardinality
+    static constexpr size_t MAX_TRACKED_LEVELS = 64;
 
 private:
     char m_delimiter;
-    std::vector<std::vector<float>> parsedFile;
-    std::vector<float> parsedWeightFile;
-    std::vector<float> parsedVetosFile;
-    std::vector<float> parsedPreferencesFile;
-    std::vector<OptimizationType> parsedOptimizationsFile;
-    float parsedConcordanceThresholdFile;
+    std::shared_ptr<Dataset> dataset;
+    std::ostream *output = &std::cout;
+
+    Dataset &editDataset();
 };
 
 #endif // PARSER_H
\ No newline at end of file
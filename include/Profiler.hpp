@@ -0,0 +1,134 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Process-wide stage profiler behind --profile.
+ *
+ * Stages are delimited by ProfileScope objects. While profiling is off a scope only tests a flag,
+ * and the counting operator new only tests the same flag before calling malloc. Every variant of
+ * the global operator new and delete is replaced, so that all of them allocate with malloc and
+ * release with free, whichever pair the standard library picks.
+ *
+ * The CPU time, allocation and RSS figures are process-wide: stages that overlap in time (for
+ * instance two algorithms run in parallel by -a ep) see each other's activity.
+ *
+ * On Linux the stages also get perf_event counters (cycles, instructions, LLC misses, branch
+ * misses), inherited by every thread started after the session. Where the hardware counters are
+ * not available, e.g. in most containers, the software task clock and page faults are counted
+ * instead, and the report says so.
+ */
+class Profiler
+{
+public:
+    static constexpr size_t MAX_COUNTERS = 4;
+    using CounterValues = std::array<uint64_t, MAX_COUNTERS>;
+
+    struct Stage
+    {
+        std::string name;
+        double startMs;
+        double wallMs;
+        double cpuMs;
+        uint64_t allocations;
+        uint64_t allocatedBytes;
+        long peakRssKb; // High-water mark of the process at the end of the stage
+        CounterValues counters;
+    };
+
+    // Resource usage at one point in time
+    struct Snapshot
+    {
+        std::chrono::steady_clock::time_point wall;
+        double cpuMs;
+        uint64_t allocations;
+        uint64_t allocatedBytes;
+        CounterValues counters;
+    };
+
+    // Read by every thread on every allocation, hence relaxed loads
+    inline static std::atomic<bool> enabled{false};
+    inline static std::atomic<uint64_t> allocationCount{0};
+    inline static std::atomic<uint64_t> allocationBytes{0};
+
+    static Snapshot snapshot();
+    static void record(const std::string &name, const Snapshot &start);
+    static bool writeReport(const std::string &path, const std::string &command);
+
+private:
+    inline static std::mutex stagesMutex;
+    inline static std::vector<Stage> stages;
+    inline static Snapshot origin;
+
+    // perf_event descriptors, counterNames[i] is empty past the opened ones
+    inline static std::array<int, MAX_COUNTERS> counterFds{};
+    inline static std::array<const char *, MAX_COUNTERS> counterNames{};
+    inline static size_t counterCount = 0;
+    inline static std::string counterSource = "clock";
+    inline static std::string counterNote;
+
+    static void openCounters();
+    static void closeCounters();
+    static CounterValues readCounters();
+
+    friend class ProfileSession;
+};
+
+/**
+ * @brief Times a stage from its construction to its destruction or to the next call to next().
+ */
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name)
+    {
+        if (Profiler::enabled.load(std::memory_order_relaxed))
+            begin(name);
+    }
+    ~ProfileScope()
+    {
+        if (name)
+            end();
+    }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+    // Ends the current stage and starts the following one
+    void next(const char *nextName)
+    {
+        if (name)
+            end();
+        if (Profiler::enabled.load(std::memory_order_relaxed))
+            begin(nextName);
+    }
+
+private:
+    const char *name = nullptr;
+    Profiler::Snapshot start;
+
+    void begin(const char *stageName);
+    void end();
+};
+
+/**
+ * @brief Enables the profiler for the lifetime of main() and writes the report when it ends.
+ */
+class ProfileSession
+{
+public:
+    ProfileSession(const std::string &path, const std::string &command);
+    ~ProfileSession();
+
+private:
+    std::string path;
+    std::string command;
+};
+
+#endif
@@ -6,11 +6,31 @@
 #include <iomanip>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
 #include "OptimizationType.hpp"
 #include "Algo.hpp"
+#include "CriterionKernels.hpp"
+#include "Reduction.hpp"
+
+// How the flow contribution of a single criterion is computed
+enum CriterionPlan
+{
+    GENERAL,  // Pairwise comparisons, O(n²)
+    COUNTING  // Value histogram and prefix counts, O(n + levels)
+};
+
+// Alternatives with a strictly lower and a strictly higher value than each alternative, on one criterion
+struct CriterionCounts
+{
+    std::vector<int> below;
+    std::vector<int> above;
+};
 
 class Promethee : public Algo
 {
+    // The microbenchmarks in bench/ time the private stages one by one
+    friend class Bench;
+
 private:
     std::vector<std::vector<float>> multicriteriaPreferenceMatrix; // Multicriteria Preference Matrix
     std::vector<float> flows;                                      // Diff btw φ+ & φ-
@@ -19,12 +39,48 @@ private:
     std::vector<int> bestAlternativesPositive;
     std::vector<int> bestAlternativesNegative;
     std::vector<int> bestAlternativesOverall;
+    std::vector<CriterionPlan> criterionPlans;
+    bool preferenceMatrixComplete = false;                         // False while COUNTING criteria are missing from the matrix
+    std::vector<std::vector<float>> partialFlows;                  // Net flow of each group of each hierarchy level, [level][alternative * groups + group]
+
+    // Anytime approximation, see runApproximate()
+    bool approximate = false;
+    double deadlineMs = 100;
+    double epsilon = 0;                                            // Target half-width on φ / (n - 1), 0 to only use the deadline
+    int topK = 10;
+    unsigned long seed = 42;
+    std::vector<float> positiveMargin;                             // Confidence interval half-widths of φ+, φ− and φ
+    std::vector<float> negativeMargin;
+    std::vector<float> flowMargin;
+    std::vector<int> rankedAlternatives;                           // Alternatives by decreasing estimated φ
+    std::vector<bool> settledPositions;                            // Whether each rank is statistically settled
+
+    // Streaming pipeline, see runStreaming()
+    std::string streamingSource;
+
+    // Precomputed per-criterion counts, see flowsFromCounts()
+    std::shared_ptr<const std::vector<CriterionCounts>> outrankingCounts;
 
     float calculatePreference(float value1, float value2);
     std::vector<int> calculatePosition(std::vector<float> valuesVec, OptimizationType order);
+    int criteriaCount();
+    void addCountingFlows(int criterium, std::vector<CompensatedSum> &positive, std::vector<CompensatedSum> &negative);
+    void completePreferenceMatrix();
+    template <int M>
+    void preferenceRows(size_t first, size_t last, std::span<const int> criteria, const float *values, bool withPartialFlows);
+    float pairPreference(int alternative1, int alternative2);
+    void runApproximate();
+    void settleRanking();
+    void runStreaming();
+    void storeFlows(const std::vector<CompensatedSum> &positive, const std::vector<CompensatedSum> &negative);
+    void flowsFromCounts();
+    void resetPartialFlows(size_t n);
+    void addPartialFlow(int criterium, int alternative, float net);
+    std::string partialFlowsName(size_t level);
+    int saveArrays(const std::filesystem::path &folderPath);
 
 public:
-    Promethee(std::vector<std::vector<float>> data, std::vector<float> weights);
+    Promethee(const std::vector<std::vector<float>> &data, const std::vector<float> &weights);
     Promethee() : Algo("Promethee", "p", "For Promethee algo", "in development") {};
 
     // Setters
@@ -33,13 +89,43 @@ public:
     void setPositiveFlow(const std::vector<float> &newPositiveFlow) { positiveFlow = newPositiveFlow; }
     void setNegativeFlow(const std::vector<float> &newNegativeFlow) { negativeFlow = newNegativeFlow; }
 
+    void setApproximation(double newDeadlineMs, double newEpsilon, int newTopK)
+    {
+        approximate = true;
+        deadlineMs = newDeadlineMs;
+        epsilon = newEpsilon;
+        topK = newTopK;
+    }
+    void setSeed(unsigned long newSeed) { seed = newSeed; }
+    void setStreamingSource(const std::string &filename) { streamingSource = filename; }
+    void setOutrankingCounts(std::shared_ptr<const std::vector<CriterionCounts>> counts) { outrankingCounts = std::move(counts); }
+
+    // Getters
+    const std::vector<float> &getFlows() const { return flows; }
+    const std::vector<int> &getBestAlternativesOverall() const { return bestAlternativesOverall; }
+    const std::vector<std::vector<float>> &getPartialFlows() const { return partialFlows; }
+
+    static void countOutranked(std::span<const float> values, std::vector<int> &below, std::vector<int> &above);
+
+    // Opponent strata of the approximation and the probability that any of the n intervals is wrong
+    static constexpr int APPROXIMATION_STRATA = 16;
+    static constexpr double APPROXIMATION_DELTA = 0.05;
+
+    // Criteria with at most this many distinct values use the COUNTING plan
+    static constexpr size_t COUNTING_MAX_LEVELS = 32;
+
+    void planCriteria();
+    void printCriteriaPlan();
     void calculatePreferenceMatrix();
     void printPreferenceMatrix();
     void calculateFlows();
     void calculateBestCandidates();
     void printFlows();
     void printLatexOutput();
-    void run() override;
+    void printApproximation();
+    bool run(TaskScheduler &taskScheduler) override;
+    std::string summary() override;
+    std::optional<std::string> cacheConfiguration() const override;
     virtual int save(std::string dirPath) override;
 };
 
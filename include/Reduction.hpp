@@ -0,0 +1,44 @@
+#ifndef REDUCTION_HPP
+#define REDUCTION_HPP
+
+#include <cmath>
+#include <cstddef>
+
+// Terms summed without compensation before being added to a CompensatedSum
+constexpr size_t REDUCTION_BLOCK = 256;
+
+/**
+ * @brief Compensated sum of the terms of a flow.
+ *
+ * A float sum depends on the order of its terms, and its rounding error grows with the number of
+ * terms: φ+ over a million alternatives loses its last digits, and two runs that add the same
+ * contributions in a different order may rank near-ties differently. The flows are therefore
+ * accumulated in double with Neumaier's variant of Kahan summation, each alternative by a single
+ * task in a fixed order (alternatives, then criteria, by index), and rounded to float once, so
+ * that they are the same for any number of threads.
+ *
+ * Long runs of terms are first summed in plain double over blocks of REDUCTION_BLOCK, which keeps
+ * the inner loop free of the compensation; the blocks are fixed by the index, not by the tasks.
+ */
+class CompensatedSum
+{
+public:
+    void add(double term)
+    {
+        double total = sum + term;
+        // The low-order bits of the smaller operand lost by the addition
+        if (std::abs(sum) >= std::abs(term))
+            compensation += (sum - total) + term;
+        else
+            compensation += (term - total) + sum;
+        sum = total;
+    }
+
+    double value() const { return sum + compensation; }
+
+private:
+    double sum = 0;
+    double compensation = 0;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include "Algo.hpp"
+
+/**
+ * @brief Content-addressed on-disk cache of the files written by Algo::save.
+ *
+ * The key is the SHA-256 of the canonical inputs of a run: the parsed values and parameters of
+ * the dataset (so formatting differences in the CSV files do not matter), the algorithm, its
+ * configuration and the program version. Each entry is a directory named after the key holding
+ * what save() wrote; entries are evicted least recently used first once the cache exceeds its
+ * size limit.
+ */
+class ResultCache
+{
+public:
+    ResultCache(const std::filesystem::path &directory, size_t maxBytes, const std::string &version)
+        : directory(directory), maxBytes(maxBytes), version(version) {}
+
+    static std::filesystem::path defaultDirectory();
+
+    std::optional<std::string> key(const Algo &algo) const;
+    bool restore(const std::string &key, const std::filesystem::path &outputDirectory);
+    bool store(const std::string &key, Algo &algo, const std::filesystem::path &outputDirectory);
+
+private:
+    std::filesystem::path directory;
+    size_t maxBytes;
+    std::string version;
+    std::mutex evictionMutex;
+
+    void evict();
+};
+
+#endif
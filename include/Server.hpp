@@ -0,0 +1,73 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include "Dataset.hpp"
+#include "Json.hpp"
+#include "Promethee.hpp"
+#include "TaskScheduler.hpp"
+
+/**
+ * @brief Resident daemon answering ranking requests on a local Unix domain socket.
+ *
+ * Each line received on a connection is a JSON request and gets a single-line JSON response:
+ *
+ *     {"dataset": "data/cars", "algorithm": "promethee", "weights": [...]}
+ *     {"ok": true, "flows": [...], "positions": [...], "ranking": [...]}
+ *
+ * `algorithm` is `promethee` (default) or `electre`; `weights`, `vetos`, `preferences`,
+ * `optimizations` (`"max"`/`"min"`) and `threshold` override the files of the dataset directory.
+ * `{"op": "stats"}` lists the resident datasets and `{"op": "shutdown"}` stops the daemon.
+ *
+ * Parsed datasets stay resident in an LRU bounded by a number of datasets, together with the
+ * per-criterion outranking counts of Promethee, which do not depend on the request parameters.
+ */
+class Server
+{
+public:
+    Server(const std::string &socketPath, size_t maxDatasets) : socketPath(socketPath), maxDatasets(std::max<size_t>(1, maxDatasets)) {}
+
+    int run(TaskScheduler &scheduler);
+
+    // Longest request line accepted
+    static constexpr size_t MAX_REQUEST_BYTES = 1 << 20;
+
+private:
+    struct LoadedDataset
+    {
+        std::string directory;
+        std::shared_ptr<const Dataset> dataset;
+        std::mutex countsMutex;
+        std::shared_ptr<const std::vector<CriterionCounts>> counts; // Computed on the first Promethee request
+    };
+
+    std::string socketPath;
+    size_t maxDatasets;
+    int listenSocket = -1;
+    std::atomic<bool> stopping{false};
+
+    // Most recently used first
+    std::list<std::shared_ptr<LoadedDataset>> residentDatasets;
+    std::unordered_map<std::string, std::list<std::shared_ptr<LoadedDataset>>::iterator> datasetIndex;
+    std::mutex datasetsMutex;
+
+    std::set<int> clients;
+    std::mutex clientsMutex;
+    std::condition_variable clientsDone;
+
+    std::shared_ptr<LoadedDataset> acquireDataset(const std::string &directory);
+    std::shared_ptr<const std::vector<CriterionCounts>> countsOf(LoadedDataset &loaded, TaskScheduler &scheduler);
+    Json handle(const Json &request, TaskScheduler &scheduler);
+    Json stats();
+    void serveConnection(int client, TaskScheduler &scheduler);
+    void stop();
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef TASK_SCHEDULER_HPP
+#define TASK_SCHEDULER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work-stealing thread pool shared by every algorithm of the process.
+ *
+ * Each worker owns a deque: it pushes and pops its own tasks at the back while idle workers steal
+ * from the front of the others. Tasks submitted from outside the pool go to an injection queue.
+ * A thread waiting for a TaskGroup runs pending tasks instead of blocking, so nested parallelism
+ * (algorithms running in parallel, each with parallel loops) never uses more threads than the pool.
+ */
+class TaskScheduler
+{
+public:
+    /**
+     * @brief Set of tasks that can be waited for and cancelled together.
+     */
+    class TaskGroup
+    {
+    public:
+        explicit TaskGroup(TaskScheduler &scheduler) : scheduler(scheduler) {}
+        // Never throws: an exception not collected by wait() is dropped with the group
+        ~TaskGroup() { drain(); }
+
+        void run(std::function<void()> task);
+        void wait();
+        void cancel() { stopSource.request_stop(); }
+        bool isCancelled() const { return stopSource.stop_requested(); }
+        std::stop_token getStopToken() const { return stopSource.get_token(); }
+
+    private:
+        friend class TaskScheduler;
+        TaskScheduler &scheduler;
+        std::atomic<size_t> pending{0};
+        std::stop_source stopSource;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        void drain();
+    };
+
+    explicit TaskScheduler(int threadCount = defaultThreadCount(), bool pinThreads = false);
+    ~TaskScheduler();
+
+    // The calling thread takes part in the work while it waits, hence the + 1
+    int getThreadCount() const { return workers.size() + 1; }
+    static int defaultThreadCount();
+
+    void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body, std::stop_token stopToken = {});
+
+private:
+    struct Task
+    {
+        std::function<void()> function;
+        TaskGroup *group;
+    };
+
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues; // One per worker, then the injection queue
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queuedTasks{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+
+    void submit(Task task);
+    bool popTask(Task &task);
+    bool runOne();
+    void execute(Task &task);
+    void workerLoop(int index, int cpu);
+};
+
+#endif
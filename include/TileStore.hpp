@@ -0,0 +1,55 @@
+#ifndef TILE_STORE_HPP
+#define TILE_STORE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Append-only scratch file of bit-packed matrix row-tiles.
+ *
+ * Each tile holds consecutive rows of a boolean n×n matrix, packed 64 columns per word and
+ * compressed with a run-length encoding of the empty words. Tiles are written and read back
+ * sequentially, so only one tile has to be resident at a time. A failed write or read is reported
+ * on std::cerr and returned as false, after which the store must not be used anymore.
+ */
+class TileStore
+{
+public:
+    TileStore(const std::filesystem::path &directory, size_t nbColumns);
+    ~TileStore();
+
+    size_t getWordsPerRow() const { return wordsPerRow; }
+    size_t getTileCount() const { return tiles.size(); }
+    size_t getBytesWritten() const { return bytesWritten; }
+
+    bool writeTile(size_t firstRow, size_t rowCount, const std::vector<uint64_t> &bits);
+    bool finish();
+    bool stream(std::vector<uint64_t> &buffer, const std::function<void(size_t row, const uint64_t *bits)> &visit) const;
+
+    static bool testBit(const uint64_t *bits, size_t column) { return (bits[column / 64] >> (column % 64)) & 1; }
+    static void setBit(uint64_t *bits, size_t column) { bits[column / 64] |= uint64_t(1) << (column % 64); }
+
+private:
+    struct TileInfo
+    {
+        size_t firstRow;
+        size_t rowCount;
+        size_t encodedWords;
+    };
+
+    std::filesystem::path filePath;
+    size_t nbColumns;
+    size_t wordsPerRow;
+    size_t bytesWritten = 0;
+    std::vector<TileInfo> tiles;
+    std::ofstream output;
+
+    static void compress(const std::vector<uint64_t> &words, size_t count, std::vector<uint64_t> &encoded);
+    static void decompress(const std::vector<uint64_t> &encoded, std::vector<uint64_t> &words);
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "../include/ArrayExport.hpp"
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+static_assert(std::endian::native == std::endian::little, "the dtypes written in the manifest are little-endian");
+
+/**
+ * @brief Builds the .npy header of an array, empty for raw files.
+ *
+ * @param dtype The NumPy dtype, e.g. "<f4".
+ * @param shape The shape of the array, in C order.
+ * @return The magic string, version, header length and dictionary, padded to 64 bytes.
+ */
+std::string ArrayExport::header(const char *dtype, const std::vector<size_t> &shape) const
+{
+    if (format != NPY)
+        return "";
+
+    std::string dictionary = std::string("{'descr': '") + dtype + "', 'fortran_order': False, 'shape': (";
+    for (size_t i = 0; i < shape.size(); i++)
+        dictionary += (i ? ", " : "") + std::to_string(shape[i]);
+    if (shape.size() == 1)
+        dictionary += ","; // (n,) is a tuple, (n) is not
+    dictionary += "), }";
+
+    size_t unpadded = 10 + dictionary.size() + 1;
+    dictionary.append((64 - unpadded % 64) % 64, ' ');
+    dictionary += '\n';
+
+    std::string result = "\x93NUMPY\x01";
+    result += '\0';
+    uint16_t length = dictionary.size();
+    result.append((const char *)&length, 2);
+    return result + dictionary;
+}
+
+std::filesystem::path ArrayExport::fileOf(const std::string &name) const
+{
+    return directory / (name + (format == NPY ? ".npy" : ".bin"));
+}
+
+void ArrayExport::record(const std::string &name, const char *dtype, const std::vector<size_t> &shape, size_t offset, Json details)
+{
+    Json shapeList = Json::array();
+    for (size_t size : shape)
+        shapeList.push(size);
+
+    Json entry = Json::object();
+    entry["name"] = name;
+    entry["file"] = fileOf(name).filename().string();
+    entry["dtype"] = dtype;
+    entry["shape"] = shapeList;
+    entry["offset"] = offset;
+    if (details.getType() == Json::OBJECT)
+    {
+        for (const char *key : {"bitorder", "logicalShape", "labels", "description"})
+        {
+            if (details.contains(key))
+                entry[key] = details[key];
+        }
+    }
+    arrays.push(entry);
+}
+
+/**
+ * @brief Writes a contiguous array with one writev(2).
+ *
+ * @return false if the file could not be written.
+ */
+bool ArrayExport::addContiguous(const std::string &name, const char *dtype, std::vector<size_t> shape, const void *data, size_t bytes)
+{
+    std::string head = header(dtype, shape);
+    std::filesystem::path path = fileOf(name);
+    unlink(path.c_str()); // Replaced rather than truncated, it may be linked into the result cache
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Error: " << path.string() << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    iovec parts[2] = {{head.data(), head.size()}, {const_cast<void *>(data), bytes}};
+    size_t remaining = head.size() + bytes;
+    int first = 0;
+    while (remaining > 0)
+    {
+        ssize_t written = writev(fd, parts + first, 2 - first);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+        {
+            std::cerr << "Error: " << path.string() << ": " << std::strerror(errno) << std::endl;
+            close(fd);
+            return false;
+        }
+        remaining -= written;
+        // Partial write: skip what was written
+        while (first < 2 && (size_t)written >= parts[first].iov_len)
+            written -= parts[first++].iov_len;
+        if (first < 2)
+        {
+            parts[first].iov_base = (char *)parts[first].iov_base + written;
+            parts[first].iov_len -= written;
+        }
+    }
+    if (close(fd) != 0)
+        return false;
+
+    record(name, dtype, shape, head.size(), Json::object());
+    return true;
+}
+
+bool ArrayExport::add(const std::string &name, std::span<const float> values)
+{
+    return addContiguous(name, "<f4", {values.size()}, values.data(), values.size_bytes());
+}
+
+bool ArrayExport::add(const std::string &name, std::span<const int> values)
+{
+    static_assert(sizeof(int) == 4);
+    return addContiguous(name, "<i4", {values.size()}, values.data(), values.size_bytes());
+}
+
+bool ArrayExport::add(const std::string &name, const std::vector<bool> &values)
+{
+    std::vector<uint8_t> bytes(values.begin(), values.end());
+    return addContiguous(name, "|u1", {values.size()}, bytes.data(), bytes.size());
+}
+
+/**
+ * @brief Writes an array stored row by row through a shared mapping of the file.
+ *
+ * @param name The array name, also the file name.
+ * @param dtype The NumPy dtype of the elements.
+ * @param shape The shape of the array, its first dimension being the number of rows.
+ * @param rowBytes The size of a row in the file.
+ * @param fillRow Writes a row at the given destination, called in parallel.
+ * @param details Optional "bitorder", "logicalShape", "labels" and "description" for the manifest.
+ * @return false if the file could not be written.
+ */
+bool ArrayExport::addRows(const std::string &name, const char *dtype, std::vector<size_t> shape, size_t rowBytes,
+                          const std::function<void(size_t row, uint8_t *destination)> &fillRow, Json details)
+{
+    std::string head = header(dtype, shape);
+    size_t rows = shape.empty() ? 0 : shape[0];
+    size_t total = head.size() + rows * rowBytes;
+    std::filesystem::path path = fileOf(name);
+
+    unlink(path.c_str());
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 || ftruncate(fd, total) != 0)
+    {
+        std::cerr << "Error: " << path.string() << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    if (total > 0)
+    {
+        void *mapping = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            std::cerr << "Error: mmap " << path.string() << ": " << std::strerror(errno) << std::endl;
+            close(fd);
+            return false;
+        }
+        uint8_t *bytes = (uint8_t *)mapping;
+        std::memcpy(bytes, head.data(), head.size());
+
+        auto fill = [&](size_t first, size_t last)
+        {
+            for (size_t row = first; row < last; row++)
+                fillRow(row, bytes + head.size() + row * rowBytes);
+        };
+        if (scheduler)
+            scheduler->parallelFor(0, rows, 0, fill);
+        else
+            fill(0, rows);
+        munmap(mapping, total);
+    }
+    if (close(fd) != 0)
+        return false;
+
+    record(name, dtype, shape, head.size(), details);
+    return true;
+}
+
+/**
+ * @brief Writes manifest.json, listing the arrays added so far.
+ *
+ * @param algorithm The name of the algorithm that produced them.
+ * @return false if the file could not be written.
+ */
+bool ArrayExport::writeManifest(const std::string &algorithm)
+{
+    Json manifest = Json::object();
+    manifest["algorithm"] = algorithm;
+    manifest["format"] = format == NPY ? "npy" : "raw";
+    manifest["arrays"] = arrays;
+
+    unlink((directory / "manifest.json").c_str());
+    std::ofstream file(directory / "manifest.json");
+    file << manifest.dump() << "\n";
+    return (bool)file;
+}
@@ -0,0 +1,184 @@
+#include "../include/Batch.hpp"
+#include "../include/BlockingQueue.hpp"
+#include "../include/Electre.hpp"
+#include "../include/Parser.hpp"
+#include "../include/Promethee.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+// ANSI escape codes for text color
+#define RESET "\033[0m"
+#define RED "\033[31m"
+#define GREEN "\033[32m"
+#define YELLOW "\033[33m"
+#define BLUE "\033[34m"
+
+/**
+ * @brief Runs every dataset found below the root.
+ *
+ * The directories are discovered by a plain thread, since it blocks on the file system and on the
+ * bounded queue, while one consumer task per scheduler thread runs the jobs. The algorithms of a
+ * job share the same scheduler for their own parallel stages.
+ *
+ * @param scheduler The process-wide scheduler.
+ * @return 0 if every job succeeded, 1 otherwise.
+ */
+int Batch::run(TaskScheduler &scheduler)
+{
+    if (!std::filesystem::is_directory(root))
+    {
+        std::cerr << "Error: " << root << " is not a directory" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int consumers = scheduler.getThreadCount();
+    BlockingQueue<Job> queue(2 * consumers);
+    int discovered = 0;
+    std::atomic<int> failed = 0;
+
+    std::cout << GREEN << "========== Batch over " << root.string() << " ==========" << RESET << "\n";
+
+    std::thread discovery([&]
+                          {
+        auto visit = [&](const std::filesystem::path &directory)
+        {
+            if (std::filesystem::is_regular_file(directory / "donnees.csv"))
+                queue.push({++discovered, directory});
+        };
+
+        visit(root);
+        std::error_code error;
+        auto iteratorOptions = std::filesystem::directory_options::skip_permission_denied;
+        for (std::filesystem::recursive_directory_iterator it(root, iteratorOptions, error), end; !error && it != end; it.increment(error))
+        {
+            if (it->is_directory())
+                visit(it->path());
+        }
+        if (error)
+            std::cerr << "Error: " << root << ": " << error.message() << std::endl;
+        queue.close(); });
+
+    TaskScheduler::TaskGroup group(scheduler);
+    for (int c = 0; c < consumers; ++c)
+    {
+        group.run([&]
+                  {
+            while (std::optional<Job> job = queue.pop())
+            {
+                if (!runJob(*job, scheduler))
+                    failed++;
+            } });
+    }
+    group.wait();
+    discovery.join();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << GREEN << "========== " << discovered << " datasets processed, " << failed << " failed in "
+              << elapsed.count() << " ms ==========" << RESET << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Parses, runs and saves one dataset, then prints its summary.
+ *
+ * @param job The dataset directory.
+ * @param scheduler The process-wide scheduler.
+ * @return false if the dataset could not be processed.
+ */
+bool Batch::runJob(const Job &job, TaskScheduler &scheduler)
+{
+    auto start = std::chrono::steady_clock::now();
+    const std::filesystem::path &directory = job.directory;
+    std::filesystem::path relative = directory.lexically_relative(root);
+    std::filesystem::path dataFile = directory / "donnees.csv";
+    bool hasVetos = std::filesystem::exists(directory / "vetos.csv");
+    bool hasOptimizations = std::filesystem::exists(directory / "optimizations.csv");
+    bool hasThreshold = std::filesystem::exists(directory / "seuilconcordance.csv");
+
+    std::ostringstream log;
+    std::vector<std::string> results;
+    std::string error;
+
+    try
+    {
+        // The streaming Promethee pipeline reads the data file itself
+        bool streamOnly = options.useStreaming && options.algorithms == "p";
+
+        Parser parser;
+        parser.setOutput(log);
+        parser.parseDirectory(directory, !streamOnly);
+        std::shared_ptr<const Dataset> dataset = parser.getDataset();
+
+        if (!streamOnly && dataset->getNbAlternatives() == 0)
+            throw std::runtime_error("no data in donnees.csv");
+        if (dataset->getWeights().empty())
+            throw std::runtime_error("no weight.csv or poids.csv");
+
+        for (char c : options.algorithms)
+        {
+            std::unique_ptr<Algo> algo;
+            if (c == 'e')
+            {
+                if (!hasVetos || !hasOptimizations || !hasThreshold)
+                {
+                    results.push_back(std::string(YELLOW) + "Electre skipped (needs vetos.csv, optimizations.csv and seuilconcordance.csv)" + RESET);
+                    continue;
+                }
+                auto electre = std::make_unique<Electre>();
+                electre->setDataset(dataset);
+                electre->setSkylinePrefilter(options.useSkyline);
+                electre->setMemoryLimit(options.memoryLimit);
+                if (!options.scratchDirectory.empty())
+                    electre->setScratchDirectory(options.scratchDirectory);
+                algo = std::move(electre);
+            }
+            else if (c == 'p')
+            {
+                auto promethee = std::make_unique<Promethee>();
+                promethee->setDataset(dataset);
+                if (options.useApproximation)
+                    promethee->setApproximation(options.deadlineMs, options.epsilon, options.topK);
+                if (options.useStreaming)
+                    promethee->setStreamingSource(dataFile);
+                algo = std::move(promethee);
+            }
+            else
+            {
+                continue;
+            }
+
+            algo->setVerbose(options.verbose);
+            algo->setOutputFormat(options.format);
+            algo->setOutput(log);
+            if (!algo->run(scheduler))
+                throw std::runtime_error(algo->getName() + " failed");
+            if (!options.outputRoot.empty())
+                algo->save(std::filesystem::path(options.outputRoot) / relative);
+            results.push_back(algo->getName() + ": " + algo->summary());
+        }
+    }
+    catch (const std::exception &exception)
+    {
+        error = exception.what();
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::lock_guard<std::mutex> lock(consoleMutex);
+    if (options.verbose)
+        std::cout << log.str();
+    if (!error.empty())
+    {
+        std::cout << RED << "✘ [" << job.index << "] " << relative.string() << ": " << error << RESET << std::endl;
+        return false;
+    }
+    std::cout << GREEN << "✔ [" << job.index << "] " << relative.string() << RESET << " (" << elapsed.count() << " ms)";
+    for (const std::string &result : results)
+        std::cout << " | " << result;
+    std::cout << std::endl;
+    return true;
+}
@@ -0,0 +1,136 @@
+#include "../include/CsvWriter.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief Creates or replaces the output file.
+ *
+ *  An existing file is unlinked rather than truncated, it may be linked into the result cache.
+ *
+ * @param path The file to write.
+ */
+CsvWriter::CsvWriter(const std::filesystem::path &path)
+{
+    unlink(path.c_str());
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        std::cerr << "Error: " << path.string() << ": " << std::strerror(errno) << std::endl;
+    buffer.reserve(BUFFER_BYTES + 64);
+}
+
+CsvWriter::~CsvWriter()
+{
+    close();
+}
+
+/**
+ * @brief Appends a float as std::ostream prints it by default (printf "%g").
+ *
+ * @param out The buffer.
+ * @param value The value.
+ */
+void CsvWriter::append(std::string &out, float value)
+{
+    char digits[32];
+    auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+    out.append(digits, end);
+}
+
+void CsvWriter::append(std::string &out, int value)
+{
+    char digits[16];
+    auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+}
+
+/**
+ * @brief Writes rows formatted in parallel, in order.
+ *
+ *  Rows are grouped in blocks of about BUFFER_BYTES, sized from the first row; each wave formats
+ *  two blocks per thread, then writes them one after the other, so that memory stays bounded.
+ *
+ * @param rowCount The number of rows.
+ * @param formatRow Appends a row, with its line ending, to the given string.
+ * @param scheduler The pool formatting the blocks, nullptr to format them on the caller.
+ */
+void CsvWriter::writeRows(size_t rowCount, const std::function<void(size_t row, std::string &out)> &formatRow, TaskScheduler *scheduler)
+{
+    if (rowCount == 0)
+        return;
+    flush();
+
+    std::string first;
+    formatRow(0, first);
+    writeAll(first);
+    size_t rowsPerBlock = std::max<size_t>(1, BUFFER_BYTES / std::max<size_t>(1, first.size()));
+    size_t blocksPerWave = scheduler ? 2 * scheduler->getThreadCount() : 1;
+
+    std::vector<std::string> blocks(blocksPerWave);
+    for (size_t waveStart = 1; waveStart < rowCount && !failed; waveStart += rowsPerBlock * blocksPerWave)
+    {
+        size_t blockCount = std::min(blocksPerWave, (rowCount - waveStart + rowsPerBlock - 1) / rowsPerBlock);
+        auto formatBlocks = [&](size_t firstBlock, size_t lastBlock)
+        {
+            for (size_t b = firstBlock; b < lastBlock; b++)
+            {
+                size_t begin = waveStart + b * rowsPerBlock;
+                size_t end = std::min(rowCount, begin + rowsPerBlock);
+                blocks[b].clear();
+                for (size_t row = begin; row < end; row++)
+                    formatRow(row, blocks[b]);
+            }
+        };
+        if (scheduler)
+            scheduler->parallelFor(0, blockCount, 1, formatBlocks);
+        else
+            formatBlocks(0, blockCount);
+
+        for (size_t b = 0; b < blockCount; b++)
+            writeAll(blocks[b]);
+    }
+}
+
+/**
+ * @brief Writes what is buffered and closes the file.
+ *
+ * @return false if any write failed.
+ */
+bool CsvWriter::close()
+{
+    if (fd < 0)
+        return false;
+    flush();
+    if (::close(fd) != 0)
+        failed = true;
+    fd = -1;
+    return !failed;
+}
+
+void CsvWriter::flush()
+{
+    writeAll(buffer);
+    buffer.clear();
+}
+
+void CsvWriter::writeAll(std::string_view bytes)
+{
+    while (!bytes.empty() && fd >= 0 && !failed)
+    {
+        ssize_t written = write(fd, bytes.data(), bytes.size());
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+        {
+            std::cerr << "Error: write: " << std::strerror(errno) << std::endl;
+            failed = true;
+            return;
+        }
+        bytes.remove_prefix(written);
+    }
+}
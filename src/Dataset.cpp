@@ -0,0 +1,155 @@
+#include "../include/Dataset.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Builds a dataset from one vector of values per alternative.
+ *
+ * @param rows The decision matrix, rows[alternative][criterium].
+ * @return A new dataset without parameters.
+ */
+std::shared_ptr<Dataset> Dataset::fromRows(const std::vector<std::vector<float>> &rows)
+{
+    size_t n = rows.size();
+    size_t m = rows.empty() ? 0 : rows[0].size();
+    std::vector<float> columns(n * m);
+    for (size_t alternative = 0; alternative < n; alternative++)
+    {
+        for (size_t criterium = 0; criterium < m; criterium++)
+            columns[criterium * n + alternative] = rows[alternative][criterium];
+    }
+
+    auto dataset = std::make_shared<Dataset>();
+    dataset->setValues(n, m, std::move(columns));
+    return dataset;
+}
+
+/**
+ * @brief Builds a dataset restricted to some alternatives, with the same parameters.
+ *
+ * @param alternatives The indexes of the alternatives to keep, in the wanted order.
+ * @return A new dataset holding a copy of the selected values only.
+ */
+std::shared_ptr<Dataset> Dataset::subset(const std::vector<int> &alternatives) const
+{
+    size_t n = alternatives.size();
+    std::vector<float> columns(n * nbCriteria);
+    for (size_t criterium = 0; criterium < nbCriteria; criterium++)
+    {
+        for (size_t i = 0; i < n; i++)
+            columns[criterium * n + i] = value(alternatives[i], criterium);
+    }
+
+    auto dataset = std::make_shared<Dataset>(*this);
+    dataset->setValues(n, nbCriteria, std::move(columns));
+    dataset->criterionCardinalities.clear();
+    return dataset;
+}
+
+/**
+ * @brief Copies the values into one vector per alternative.
+ *
+ * @return The decision matrix, rows[alternative][criterium].
+ */
+std::vector<std::vector<float>> Dataset::toRows() const
+{
+    std::vector<std::vector<float>> rows(nbAlternatives, std::vector<float>(nbCriteria));
+    for (size_t alternative = 0; alternative < nbAlternatives; alternative++)
+    {
+        for (size_t criterium = 0; criterium < nbCriteria; criterium++)
+            rows[alternative][criterium] = value(alternative, criterium);
+    }
+    return rows;
+}
+
+/**
+ * @brief Expands a column to floats.
+ *
+ * @param criterium The criterion.
+ * @return The values of the criterion for every alternative.
+ */
+std::vector<float> Dataset::expandColumn(size_t criterium) const
+{
+    std::vector<float> cells(nbAlternatives);
+    for (size_t alternative = 0; alternative < nbAlternatives; alternative++)
+        cells[alternative] = value(alternative, criterium);
+    return cells;
+}
+
+/**
+ * @brief Replaces the values of the dataset.
+ *
+ * @param newNbAlternatives The number of alternatives.
+ * @param newNbCriteria The number of criteria.
+ * @param criterionMajorValues The values of the first criterion for every alternative, then the second, and so on.
+ */
+void Dataset::setValues(size_t newNbAlternatives, size_t newNbCriteria, std::vector<float> criterionMajorValues)
+{
+    nbAlternatives = newNbAlternatives;
+    nbCriteria = newNbCriteria;
+    encodeColumns(criterionMajorValues);
+}
+
+/**
+ * @brief Chooses the storage of every column from its range and stores it at that width only.
+ *
+ *  A column qualifies for an integer storage when all its values are integers small enough for a
+ *  float to hold them and their differences exactly (|value| ≤ 2²⁴), and none is -0, which
+ *  `minimum + offset` would not give back; its range then decides between 8 and 16 bits.
+ *  Anything else, fractions included, stays in 32-bit floats.
+ *
+ * @param criterionMajorValues The values, criterion by criterion.
+ */
+void Dataset::encodeColumns(const std::vector<float> &criterionMajorValues)
+{
+    constexpr float EXACT_INTEGERS = 1 << 24;
+
+    encodings.assign(nbCriteria, {});
+    for (size_t criterium = 0; criterium < nbCriteria; criterium++)
+    {
+        std::span<const float> cells(criterionMajorValues.data() + criterium * nbAlternatives, nbAlternatives);
+        if (cells.empty())
+            continue;
+
+        auto [lowest, highest] = std::minmax_element(cells.begin(), cells.end());
+        ColumnEncoding &encoding = encodings[criterium];
+        encoding.minimum = *lowest;
+        encoding.maximum = *highest;
+
+        bool integers = std::all_of(cells.begin(), cells.end(), [](float value)
+                                    { return std::abs(value) <= EXACT_INTEGERS && value == std::nearbyint(value) && !(value == 0 && std::signbit(value)); });
+        if (!integers)
+            continue;
+        float range = encoding.maximum - encoding.minimum;
+        if (range <= UINT8_MAX)
+            encoding.storage = STORAGE_UINT8;
+        else if (range <= UINT16_MAX)
+            encoding.storage = STORAGE_UINT16;
+    }
+
+    // Every column starts on a multiple of 4 bytes, so that the 16-bit and float ones are aligned
+    size_t bytes = 0;
+    for (ColumnEncoding &encoding : encodings)
+    {
+        encoding.offset = bytes;
+        size_t width = encoding.storage == STORAGE_UINT8 ? 1 : encoding.storage == STORAGE_UINT16 ? 2 : 4;
+        bytes += (nbAlternatives * width + 3) / 4 * 4;
+    }
+    auto buffer = std::make_shared<std::vector<std::byte>>(bytes);
+    for (size_t criterium = 0; criterium < nbCriteria; criterium++)
+    {
+        const ColumnEncoding &encoding = encodings[criterium];
+        std::span<const float> cells(criterionMajorValues.data() + criterium * nbAlternatives, nbAlternatives);
+        std::byte *destination = buffer->data() + encoding.offset;
+        if (encoding.storage == STORAGE_UINT8)
+            std::transform(cells.begin(), cells.end(), reinterpret_cast<uint8_t *>(destination), [&](float value)
+                           { return (uint8_t)(value - encoding.minimum); });
+        else if (encoding.storage == STORAGE_UINT16)
+            std::transform(cells.begin(), cells.end(), reinterpret_cast<uint16_t *>(destination), [&](float value)
+                           { return (uint16_t)(value - encoding.minimum); });
+        else
+            std::copy(cells.begin(), cells.end(), reinterpret_cast<float *>(destination));
+    }
+    storage = std::move(buffer);
+}
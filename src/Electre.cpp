@@ -1,4 +1,13 @@
 #include "../include/Electre.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/CsvWriter.hpp"
+#include "../include/ArrayExport.hpp"
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <bit>
+#include <type_traits>
 
 #define RESET "\033[0m"
 #define RED "\033[31m"
@@ -17,37 +26,127 @@
  * @param concordanceThreshold A floating-point number representing the threshold for concordance.
  */
 Electre::Electre(
-    std::vector<std::vector<float>> values,
-    std::vector<float> weights,
-    std::vector<float> vetos,
-    std::vector<OptimizationType> optimizations,
+    const std::vector<std::vector<float>> &values,
+    const std::vector<float> &weights,
+    const std::vector<float> &vetos,
+    const std::vector<OptimizationType> &optimizations,
     float concordanceThreshold) : Electre()
 {
-    this->values = values;
-    this->weights = weights;
-    this->vetos = vetos;
-    this->concordanceThreshold = concordanceThreshold;
-    this->optimizations = optimizations;
+    auto newDataset = Dataset::fromRows(values);
+    newDataset->setWeights(weights);
+    newDataset->setVetos(vetos);
+    newDataset->setOptimizations(optimizations);
+    newDataset->setConcordanceThreshold(concordanceThreshold);
+    newDataset->setPreferenceThresholds(std::vector<float>(weights.size(), 0.0));
+    setDataset(newDataset);
+    resetMatrixes();
+}
 
-    nbCandidates = values.size();
-    nbCriteria = weights.size();
-    preferenceThresholds = std::vector<float>(nbCriteria, 0.0);
+Electre::Electre(
+    const std::vector<std::vector<float>> &values,
+    const std::vector<float> &weights,
+    const std::vector<float> &vetos,
+    const std::vector<float> &preferenceThresholds,
+    const std::vector<OptimizationType> &optimizations,
+    float concordanceThreshold) : Electre::Electre(values, weights, vetos, optimizations, concordanceThreshold)
+{
+    setPreferenceThresholds(preferenceThresholds);
+}
+
+/**
+ * @brief Borrows a dataset and refreshes the views over its parameters.
+ *
+ * @param newDataset The dataset to work on.
+ */
+void Electre::setDataset(std::shared_ptr<const Dataset> newDataset)
+{
+    Algo::setDataset(std::move(newDataset));
+    vetos = dataset->getVetos();
+    preferenceThresholds = dataset->getPreferenceThresholds();
+    optimizations = dataset->getOptimizations();
+    concordanceThreshold = dataset->getConcordanceThreshold();
+    nbCandidates = dataset->getNbAlternatives();
+    nbCriteria = std::min(weights.size(), dataset->getNbCriteria());
+}
 
+/**
+ * @brief Sizes the matrixes and the kernel for the current candidates.
+ */
+void Electre::resetMatrixes()
+{
     concordance = std::vector<std::vector<float>>(nbCandidates, std::vector<float>(nbCandidates, 0.0));
     nonDiscordance = std::vector<std::vector<bool>>(nbCandidates, std::vector<bool>(nbCandidates, true));
     kernel = std::vector<bool>(nbCandidates, true);
     dominance = std::vector<std::vector<bool>>(nbCandidates, std::vector<bool>(nbCandidates, false));
 }
 
-Electre::Electre(
-    std::vector<std::vector<float>> values,
-    std::vector<float> weights,
-    std::vector<float> vetos,
-    std::vector<float> preferenceThresholds,
-    std::vector<OptimizationType> optimizations,
-    float concordanceThreshold) : Electre::Electre(values, weights, vetos, optimizations, concordanceThreshold)
+/**
+ * @brief Points every criterion at a column where higher is better.
+ *
+ *  Each criterion is read at the width the dataset chose for it: the integer columns move 1 or 2
+ *  bytes per value through the O(n²) stages instead of 4, whatever the other columns hold. Floats
+ *  have their MIN criteria negated. Integers are read as value − minimum, or maximum − value for
+ *  MIN criteria. Both are exact, so comparing and subtracting oriented values gives the same
+ *  results as flipping the comparisons of the MIN criteria, without a direction test per pair.
+ *  MAX criteria are read in place, MIN criteria are copied at their width. Called by every stage
+ *  that reads oriented values; the setters only swap the dataset, so nothing is copied again until
+ *  the values or the optimizations change.
+ */
+void Electre::orientValues()
 {
-    this->preferenceThresholds = preferenceThresholds;
+    std::vector<OptimizationType> wanted(nbCriteria, MAX);
+    for (int criterium = 0; criterium < nbCriteria && (size_t)criterium < optimizations.size(); criterium++)
+        wanted[criterium] = optimizations[criterium];
+    if (orientedSource && orientedSource->getStorage() == dataset->getStorage() && orientedOptimizations == wanted)
+        return;
+
+    orientedOptimizations = std::move(wanted);
+    orientedStorages.assign(nbCriteria, STORAGE_FP32);
+    orientedColumns.assign(nbCriteria, nullptr);
+
+    // Every copy starts on a multiple of 4 bytes, like the columns of the dataset
+    auto copyBytes = [&](int criterium)
+    {
+        ColumnStorage storage = dataset->encoding(criterium).storage;
+        return (nbCandidates * (storage == STORAGE_UINT8 ? 1 : storage == STORAGE_UINT16 ? 2 : 4) + 3) / 4 * 4;
+    };
+    size_t bytes = 0;
+    for (int criterium = 0; criterium < nbCriteria; criterium++)
+    {
+        if (orientedOptimizations[criterium] == MIN)
+            bytes += copyBytes(criterium);
+    }
+    orientedCopies.resize(bytes);
+
+    std::byte *destination = orientedCopies.data();
+    for (int criterium = 0; criterium < nbCriteria; criterium++)
+    {
+        const ColumnEncoding &encoding = dataset->encoding(criterium);
+        const std::byte *cells = dataset->columnData(criterium);
+        orientedStorages[criterium] = encoding.storage;
+        orientedColumns[criterium] = cells;
+        if (orientedOptimizations[criterium] != MIN)
+            continue;
+
+        auto flip = [&]<typename T>(auto orient)
+        {
+            const T *source = reinterpret_cast<const T *>(cells);
+            std::transform(source, source + nbCandidates, reinterpret_cast<T *>(destination), orient);
+        };
+        int range = encoding.maximum - encoding.minimum;
+        if (encoding.storage == STORAGE_UINT8)
+            flip.operator()<uint8_t>([range](uint8_t value)
+                                     { return (uint8_t)(range - value); });
+        else if (encoding.storage == STORAGE_UINT16)
+            flip.operator()<uint16_t>([range](uint16_t value)
+                                      { return (uint16_t)(range - value); });
+        else
+            flip.operator()<float>([](float value)
+                                   { return -value; });
+        orientedColumns[criterium] = destination;
+        destination += copyBytes(criterium);
+    }
+    orientedSource = dataset;
 }
 
 /**
@@ -55,137 +154,343 @@ Electre::Electre(
  *
  *  This method iterates through the values matrix and calculates the concordance values for each pair of attributes.
  *  The concordance value represents the degree to which two attributes agree on the relative preference of alternatives.
+ *  The pairs are compared by concordanceRows(). A cell sums its criteria in index order within
+ *  one task, so the matrix, and the threshold decisions made on it, do not depend on the number
+ *  of threads.
  */
 void Electre::processConcordance()
 {
-    for (int y = 0; y < values.size() - 1; y++)
+    orientValues();
+
+    // Task y writes row y and column y, no two tasks write the same cell
+    parallelFor(0, std::max(nbCandidates - 1, 0), [&](size_t first, size_t last)
+                { concordanceRows(first, last); });
+}
+
+/**
+ * @brief Concordance of the rows [first, last) over the following candidates, and of those over them.
+ *
+ *  A row is accumulated criterion by criterion, each one read by the instantiation for its own
+ *  storage, in index order so that every cell adds the same terms in the same order as a loop
+ *  over the criteria of each pair.
+ */
+void Electre::concordanceRows(size_t first, size_t last)
+{
+    // 8-bit values differ by at most 255: the coefficient of every difference is computed once
+    std::vector<double> coefficients((size_t)nbCriteria * 256, 0);
+    for (int criterium = 0; criterium < nbCriteria; criterium++)
     {
-        for (int x = y + 1; x < values.size(); x++)
-        {
-            float concordVal1 = 0;
-            float concordVal2 = 0;
+        float threshold = preferenceThresholds.empty() ? 0 : preferenceThresholds[criterium];
+        if (orientedStorages[criterium] != STORAGE_UINT8 || threshold == 0)
+            continue;
+        for (int diff = 0; diff < 256; diff++)
+            coefficients[criterium * 256 + diff] = 1 - std::min(1.0, (double)diff / threshold);
+    }
 
-            for (int criterium = 0; criterium < weights.size(); criterium++)
+    std::vector<float> under(nbCandidates); // Concordance of the following candidates over y
+    for (int y = first; y < (int)last; y++)
+    {
+        float *over = concordance[y].data();
+        std::fill(over + y + 1, over + nbCandidates, 0.0f);
+        std::fill(under.begin() + y + 1, under.end(), 0.0f);
+        for (int criterium = 0; criterium < nbCriteria; criterium++)
+        {
+            const double *table = coefficients.data() + criterium * 256;
+            switch (orientedStorages[criterium])
             {
-                float candidateVal1 = values[y][criterium];
-                float candidateVal2 = values[x][criterium];
+            case STORAGE_UINT8:
+                concordanceCriterion<uint8_t>(criterium, y, table, over, under.data());
+                break;
+            case STORAGE_UINT16:
+                concordanceCriterion<uint16_t>(criterium, y, table, over, under.data());
+                break;
+            default:
+                concordanceCriterion<float>(criterium, y, table, over, under.data());
+            }
+        }
+        for (int x = y + 1; x < nbCandidates; x++)
+            concordance[x][y] = under[x];
+    }
+}
+
+/**
+ * @brief Adds one criterion to the concordances of row y over the following candidates, and of those over it.
+ *
+ * @tparam T The storage of the criterion's oriented values.
+ * @param coefficients The coefficient of every 8-bit difference, only read for 8-bit storage.
+ * @param over The concordances of y over the candidates.
+ * @param under The concordances of the candidates over y.
+ */
+template <typename T>
+void Electre::concordanceCriterion(int criterium, int y, const double *coefficients, float *over, float *under)
+{
+    const T *cells = orientedColumn<T>(criterium);
+    float threshold = preferenceThresholds.empty() ? 0 : preferenceThresholds[criterium];
+    float val = weights[criterium];
+    float candidateVal1 = cells[y];
+    for (int x = y + 1; x < nbCandidates; x++)
+    {
+        float candidateVal2 = cells[x];
 
-                float threshold = 0;
-                if (!preferenceThresholds.empty())
-                    threshold = preferenceThresholds[criterium];
+        double diff = std::abs(candidateVal1 - candidateVal2);
+        double coeff = 0;
+        if constexpr (std::is_same_v<T, uint8_t>)
+            coeff = coefficients[(int)diff];
+        else if (threshold != 0)
+            coeff = 1 - std::min(1.0, diff / threshold);
 
-                float val = weights[criterium];
+        if (candidateVal1 == candidateVal2)
+        {
+            over[x] += val;
+            under[x] += val;
+        }
+        else if (candidateVal1 > candidateVal2)
+        {
+            over[x] += val;
+            under[x] += coeff * val;
+        }
+        else
+        {
+            under[x] += val;
+            over[x] += coeff * val;
+        }
+    }
+}
 
-                double diff = std::abs(candidateVal1 - candidateVal2);
-                double coeff = 0;
-                if (threshold != 0)
-                    coeff = 1 - std::min(1.0, diff / threshold);
+/**
+ * @brief Concordance of one candidate over another.
+ *
+ *  Same computation as processConcordance() for a single ordered pair, used when the concordance
+ *  matrix is not materialised.
+ *
+ * @param candidate1 The candidate that may outrank.
+ * @param candidate2 The candidate that may be outranked.
+ * @return The concordance of candidate1 over candidate2.
+ */
+float Electre::pairConcordance(int candidate1, int candidate2)
+{
+    float concordVal = 0;
+    for (int criterium = 0; criterium < nbCriteria; criterium++)
+    {
+        float candidateVal1 = oriented(candidate1, criterium);
+        float candidateVal2 = oriented(candidate2, criterium);
 
-                if (candidateVal1 == candidateVal2)
-                {
-                    concordVal1 += val;
-                    concordVal2 += val;
-                    continue;
-                }
+        float threshold = 0;
+        if (!preferenceThresholds.empty())
+            threshold = preferenceThresholds[criterium];
 
-                if (optimizations[criterium] == MIN)
-                {
-                    if (candidateVal1 < candidateVal2)
-                    {
-                        concordVal1 += val;
-                        concordVal2 += coeff * val;
-                        continue;
-                    }
+        float val = weights[criterium];
 
-                    concordVal2 += val;
-                    concordVal1 += coeff * val;
-                }
-                else
-                {
-                    if (candidateVal1 > candidateVal2)
-                    {
-                        concordVal1 += val;
-                        concordVal2 += coeff * val;
-                        continue;
-                    }
+        double diff = std::abs(candidateVal1 - candidateVal2);
+        double coeff = 0;
+        if (threshold != 0)
+            coeff = 1 - std::min(1.0, diff / threshold);
 
-                    concordVal2 += val;
-                    concordVal1 += coeff * val;
-                }
-            }
+        if (candidateVal1 >= candidateVal2)
+            concordVal += val;
+        else
+            concordVal += coeff * val;
+    }
+    return concordVal;
+}
 
-            concordance[y][x] = concordVal1;
-            concordance[x][y] = concordVal2;
-        }
+/**
+ * @brief Non-discordance of one candidate over another.
+ *
+ *  Same test as processNondiscordance() for a single ordered pair.
+ *
+ * @param candidate1 The candidate that may outrank.
+ * @param candidate2 The candidate that may be outranked.
+ * @return false if a veto prevents candidate1 from outranking candidate2.
+ */
+bool Electre::pairNonDiscordance(int candidate1, int candidate2)
+{
+    if (candidate1 == candidate2)
+        return false;
+
+    for (int criterium = 0; criterium < nbCriteria; criterium++)
+    {
+        // How much candidate2 is better, oriented values being higher when better
+        double diff = (double)oriented(candidate2, criterium) - oriented(candidate1, criterium);
+        if (diff > vetos[criterium])
+            return false;
     }
+    return true;
 }
 
+/**
+ * @brief Calculates the nondiscordance matrix.
+ *
+ *  A candidate cannot outrank another that beats it by more than the veto on any criterion. The
+ *  pairs are tested by nonDiscordanceRows().
+ */
 void Electre::processNondiscordance()
 {
-    for (int criterium = 0; criterium < weights.size(); criterium++)
+    orientValues();
+
+    // Each row is written by a single task
+    parallelFor(0, nbCandidates, [&](size_t first, size_t last)
+                { nonDiscordanceRows(first, last); });
+}
+
+/**
+ * @brief Nondiscordance of the rows [first, last).
+ *
+ *  The vetos of a row are gathered criterion by criterion, each one read by the instantiation for
+ *  its own storage.
+ */
+void Electre::nonDiscordanceRows(size_t first, size_t last)
+{
+    std::vector<uint8_t> vetoed(nbCandidates);
+    for (int y = first; y < (int)last; y++)
     {
-        for (int y = 0; y < values.size(); y++)
+        std::fill(vetoed.begin(), vetoed.end(), 0);
+        for (int criterium = 0; criterium < nbCriteria; criterium++)
         {
-            for (int x = 0; x < values.size(); x++)
+            switch (orientedStorages[criterium])
             {
-                if (y == x)
+            case STORAGE_UINT8:
+                nonDiscordanceCriterion<uint8_t>(criterium, y, vetoed.data());
+                break;
+            case STORAGE_UINT16:
+                nonDiscordanceCriterion<uint16_t>(criterium, y, vetoed.data());
+                break;
+            default:
+                nonDiscordanceCriterion<float>(criterium, y, vetoed.data());
+            }
+        }
+        for (int x = 0; x < nbCandidates; x++)
+            nonDiscordance[y][x] = x != y && !vetoed[x];
+    }
+}
+
+/**
+ * @brief Marks the candidates that beat row y by more than the veto of one criterion.
+ *
+ * @tparam T The storage of the criterion's oriented values.
+ * @param vetoed Set for every candidate vetoed on this criterion, left as is otherwise.
+ */
+template <typename T>
+void Electre::nonDiscordanceCriterion(int criterium, int y, uint8_t *vetoed)
+{
+    const T *cells = orientedColumn<T>(criterium);
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        float veto = vetos[criterium];
+        for (int x = 0; x < nbCandidates; x++)
+            vetoed[x] |= (double)cells[x] - cells[y] > veto;
+    }
+    else
+    {
+        // Integer values have integer differences: diff > veto is diff > ⌊veto⌋, tested without
+        // converting to double. The vetos are clamped beyond the 16-bit differences, NaN never vetoes.
+        int veto = std::isnan(vetos[criterium]) ? UINT16_MAX : std::clamp<double>(std::floor(vetos[criterium]), -UINT16_MAX - 1, UINT16_MAX);
+        int value = cells[y];
+        for (int x = 0; x < nbCandidates; x++)
+            vetoed[x] |= (int)cells[x] - value > veto;
+    }
+}
+
+/**
+ * @brief Computes the dominance relation from the concordance and nondiscordance matrixes.
+ *
+ *  The edges are also collected row by row as a compressed sparse row graph. When the relation is
+ *  sparse enough, the cycle detection, cycle breaking and kernel extraction walk these adjacency
+ *  lists instead of full matrix rows; otherwise the lists are dropped.
+ */
+void Electre::processDominance()
+{
+    // Rows are computed in parallel, then their successors are concatenated in order
+    std::vector<std::vector<int>> rowSuccessors(nbCandidates);
+    parallelFor(0, nbCandidates, [&](size_t first, size_t last)
                 {
-                    nonDiscordance[y][x] = false;
+        for (int y = first; y < (int)last; y++)
+        {
+            for (int x = 0; x < nbCandidates; x++)
+            {
+                if (concordance[y][x] < concordanceThreshold)
                     continue;
-                }
 
                 if (!nonDiscordance[y][x])
                     continue;
 
-                double candidateVal1 = values[y][criterium];
-                double candidateVal2 = values[x][criterium];
-                float veto = vetos[criterium];
-
-                if (optimizations[criterium] == MAX)
-                {
-                    candidateVal1 = -candidateVal1;
-                    candidateVal2 = -candidateVal2;
-                }
-
-                double diff = candidateVal1 - candidateVal2;
-
-                if (diff > veto)
-                {
-                    nonDiscordance[y][x] = false;
-                    continue;
-                }
+                dominance[y][x] = true;
+                rowSuccessors[y].push_back(x);
             }
-        }
-    }
-}
+        } });
 
-void Electre::processDominance()
-{
-    for (int y = 0; y < values.size(); y++)
+    successorOffsets.assign(1, 0);
+    successors.clear();
+    for (int y = 0; y < nbCandidates; y++)
     {
-        for (int x = 0; x < values.size(); x++)
-        {
-            if (concordance[y][x] < concordanceThreshold)
-                continue;
+        successors.insert(successors.end(), rowSuccessors[y].begin(), rowSuccessors[y].end());
+        successorOffsets.push_back(successors.size());
+        rowSuccessors[y] = std::vector<int>();
+    }
 
-            if (!nonDiscordance[y][x])
-                continue;
+    size_t edges = successors.size();
+    double pairs = (double)nbCandidates * (nbCandidates - 1);
+    useSparseGraph = pairs > 0 && edges < SPARSE_GRAPH_DENSITY * pairs;
+    if (useSparseGraph)
+    {
+        successorAlive.assign(successors.size(), true);
+    }
+    else
+    {
+        successorOffsets = std::vector<int>();
+        successors = std::vector<int>();
+        successorAlive = std::vector<bool>();
+    }
 
-            dominance[y][x] = true;
-        }
+    if (verbose)
+    {
+        log() << "Dominance graph: " << edges << " edges, "
+                  << (useSparseGraph ? "adjacency lists used" : "too dense, matrix rows used") << "\n";
     }
 }
 
+/**
+ * @brief Breaks the cycles of the dominance graph and selects the kernel.
+ *
+ *  The paths and cycles of the search are allocated from a monotonic arena, seeded with a buffer
+ *  on the stack and released as a whole when the stage returns, so that the graph stage makes
+ *  no heap allocation on small graphs and no individual frees on large ones.
+ */
 void Electre::processKernel()
 {
-    std::vector<std::vector<int>> cycles = getCycles();
+    std::array<std::byte, 16 * 1024> arenaBuffer;
+    std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+
+    ProfileScope stage("Electre/kernel/cycles");
+    Cycles cycles = getCycles(&arena);
+    stage.next("Electre/kernel/cycleBreaking");
     if (cycles.size() != 0)
         deleteCycles(cycles);
+    stage.next("Electre/kernel/selection");
 
     // get kernel
-    for (int y = 0; y < values.size(); y++)
+    if (useSparseGraph)
     {
-        for (int x = 0; x < values.size(); x++)
+        for (int y = 0; y < nbCandidates; y++)
+        {
+            for (int edge = successorOffsets[y]; edge < successorOffsets[y + 1]; edge++)
+            {
+                int x = successors[edge];
+                if (!successorAlive[edge] || !kernel[x])
+                    continue;
+
+                if (concordance[y][x] < concordanceThreshold)
+                    continue;
+
+                kernel[x] = false;
+            }
+        }
+        return;
+    }
+
+    for (int y = 0; y < nbCandidates; y++)
+    {
+        for (int x = 0; x < nbCandidates; x++)
         {
             if (!kernel[x])
                 continue;
@@ -201,135 +506,280 @@ void Electre::processKernel()
     }
 }
 
-std::vector<std::vector<int>> Electre::getCycles()
+/**
+ * @brief Finds the distinct cycles of the dominance graph.
+ *
+ *  The search starts from every candidate in index order, or in cycleSearchOrder when it is set.
+ *  The order decides which rotation of a cycle is found first, and so which link deleteCycles()
+ *  keeps on ties.
+ *
+ * @param arena The resource of the paths and cycles.
+ * @return The cycles, each listed once whatever its starting candidate, in discovery order.
+ */
+Electre::Cycles Electre::getCycles(std::pmr::memory_resource *arena)
 {
-    std::vector<std::vector<int>> cycles;
-
-    for (int candidate = 0; candidate < values.size(); candidate++)
+    Cycles cycles(arena);
+    Path path(arena);
+    if (!cycleSearchOrder.empty())
     {
-        std::vector<std::vector<int>> returnedVector = getSuccessorCycles(candidate, std::vector<int>());
-
-        if (returnedVector.empty())
-            continue;
-
-        // filtering the identical cycles; keeping only unique ones
-        for (int retInd = 0; retInd < returnedVector.size(); retInd++)
-        {
-            bool cyclePresent = false;
-            std::vector<int> retVec = returnedVector[retInd];
-
-            for (int cycleInd = 0; cycleInd < cycles.size(); cycleInd++)
-            {
-                std::vector<int> cycleVec = cycles[cycleInd];
-
-                // compare the selected cycle to the others that are getting returned
-                if (hasSameElements(retVec, cycleVec))
-                {
-                    cyclePresent = true;
-                    break;
-                }
-            }
-
-            if (!cyclePresent)
-                cycles.push_back(retVec);
-        }
+        for (int candidate : cycleSearchOrder)
+            getSuccessorCycles(candidate, path, cycles);
+        return cycles;
     }
-
+    for (int candidate = 0; candidate < nbCandidates; candidate++)
+        getSuccessorCycles(candidate, path, cycles);
     return cycles;
 }
 
-std::vector<std::vector<int>> Electre::getSuccessorCycles(int candidate, std::vector<int> visitedChilds)
+/**
+ * @brief Walks every path from a candidate and records the cycles closing on it.
+ *
+ * @param candidate The candidate reached.
+ * @param path The candidates visited before it, restored on return.
+ * @param cycles The cycles found so far.
+ */
+void Electre::getSuccessorCycles(int candidate, Path &path, Cycles &cycles)
 {
-    for (int i = 0; i < visitedChilds.size(); i++)
+    auto visited = std::find(path.begin(), path.end(), candidate);
+    if (visited != path.end())
     {
-        if (candidate == visitedChilds[i])
-            // return the sliced vector containing the cycle
-            return std::vector<std::vector<int>>{std::vector(visitedChilds.begin() + i, visitedChilds.end())};
-        ;
+        // The path from the first visit of the candidate is a cycle
+        addCycle({visited, path.end()}, cycles);
+        return;
     }
 
-    visitedChilds.push_back(candidate);
-
-    std::vector<std::vector<int>> returnVector{};
-
-    for (int i = 0; i < values.size(); i++)
+    path.push_back(candidate);
+    if (useSparseGraph)
     {
-        if (dominance[candidate][i] == 1)
+        for (int edge = successorOffsets[candidate]; edge < successorOffsets[candidate + 1]; edge++)
+            getSuccessorCycles(successors[edge], path, cycles);
+    }
+    else
+    {
+        for (int i = 0; i < nbCandidates; i++)
         {
-            std::vector<std::vector<int>> cycleVector = getSuccessorCycles(i, visitedChilds);
-
-            // flattening into vector<vector<int>>
-            for (std::vector<int> vec : cycleVector)
-            {
-                returnVector.push_back(vec);
-            }
+            if (dominance[candidate][i] == 1)
+                getSuccessorCycles(i, path, cycles);
         }
     }
+    path.pop_back();
+}
 
-    return returnVector;
+/**
+ * @brief Keeps a cycle unless one with the same candidates was already found.
+ */
+void Electre::addCycle(std::span<const int> cycle, Cycles &cycles)
+{
+    for (const Path &known : cycles)
+    {
+        if (hasSameElements(cycle, known))
+            return;
+    }
+    cycles.emplace_back(cycle.begin(), cycle.end());
 }
 
-bool Electre::hasSameElements(std::vector<int> vec1, std::vector<int> vec2)
+bool Electre::hasSameElements(std::span<const int> vec1, std::span<const int> vec2)
 {
     if (vec1.size() != vec2.size())
         return false;
 
-    std::vector<int> tempVec;
+    return std::all_of(vec1.begin(), vec1.end(), [&](int el1)
+                       { return std::find(vec2.begin(), vec2.end(), el1) != vec2.end(); });
+}
 
-    for (int el1 : vec1)
+/**
+ * @brief Breaks every cycle by keeping only its link of highest concordance.
+ *
+ * @param cycles The cycles, link i going from cycle[i] to the next candidate of the cycle.
+ */
+void Electre::deleteCycles(const Cycles &cycles)
+{
+    for (const Path &cycle : cycles)
     {
-        for (int el2 : vec2)
+        auto linkEnd = [&cycle](size_t linkIndex)
+        { return cycle[(linkIndex + 1) % cycle.size()]; };
+
+        // find the highest concordance values, and the link index
+        size_t highestConcordanceLinkIndex = 0;
+        float highestConcordanceValue = 0.0;
+        for (size_t i = 0; i < cycle.size(); i++)
         {
-            if (el1 == el2)
+            float concorValue = concordance[cycle[i]][linkEnd(i)];
+            if (concorValue > highestConcordanceValue)
             {
-                tempVec.push_back(el1);
-                break;
+                highestConcordanceValue = concorValue;
+                highestConcordanceLinkIndex = i;
             }
         }
+
+        // delete the links
+        for (size_t i = 0; i < cycle.size(); i++)
+        {
+            if (i != highestConcordanceLinkIndex)
+                deleteLink(cycle[i], linkEnd(i));
+        }
     }
+}
 
-    return (tempVec.size() == vec1.size());
+/**
+ * @brief Removes an edge from the dominance graph.
+ *
+ * @param start The candidate that dominates.
+ * @param end The dominated candidate.
+ */
+void Electre::deleteLink(int start, int end)
+{
+    dominance[start][end] = 0;
+    if (!useSparseGraph)
+        return;
+
+    auto first = successors.begin() + successorOffsets[start];
+    auto last = successors.begin() + successorOffsets[start + 1];
+    auto it = std::lower_bound(first, last, end);
+    if (it != last && *it == end)
+        successorAlive[it - successors.begin()] = false;
 }
 
-void Electre::deleteCycles(std::vector<std::vector<int>> cycles)
+/**
+ * @brief Checks whether a candidate Pareto-dominates another one.
+ *
+ *  The first candidate must be at least as good as the second on every criterion, according to the
+ *  criterion's optimization type, and strictly better on at least one of them.
+ *
+ * @param candidate1 The candidate that may dominate.
+ * @param candidate2 The candidate that may be dominated.
+ * @return true if candidate1 Pareto-dominates candidate2.
+ */
+bool Electre::paretoDominates(int candidate1, int candidate2)
 {
-    for (std::vector<int> cycle : cycles)
+    bool strictlyBetter = false;
+    for (int criterium = 0; criterium < nbCriteria; criterium++)
     {
-        std::vector<std::array<int, 2>> links;
+        float val1 = oriented(candidate1, criterium);
+        float val2 = oriented(candidate2, criterium);
 
-        // init links
-        for (int linkIndex = 0; linkIndex < cycle.size(); linkIndex++)
+        if (val1 < val2)
+            return false;
+        if (val1 > val2)
+            strictlyBetter = true;
+    }
+    return strictlyBetter;
+}
+
+/**
+ * @brief Checks the conditions under which the skyline pre-pass is used.
+ *
+ *  A Pareto-dominated candidate is outranked by its dominator only if the dominator reaches the
+ *  concordance threshold with all the weights, and is never vetoed if all vetos are non-negative.
+ *  The kernel is kept only if no dominated candidate outranks any other, see prunedOutrankNone().
+ *
+ * @return true if the skyline pre-pass can be used with the current parameters.
+ */
+bool Electre::canUseSkyline()
+{
+    for (int criterium = 0; criterium < nbCriteria; criterium++)
+    {
+        if (vetos[criterium] < 0)
+            return false;
+    }
+    float totalWeight = std::accumulate(weights.begin(), weights.end(), 0.0f);
+    return concordanceThreshold <= totalWeight;
+}
+
+/**
+ * @brief Computes the skyline (Pareto front) of the candidates.
+ *
+ *  Sort-filter-skyline: the candidates are sorted by decreasing sum of their oriented values, a
+ *  monotone score, so a candidate can only be dominated by candidates seen before it. Each candidate
+ *  is compared with the current window of skyline candidates; the window is still pruned when a
+ *  later candidate dominates, which can happen when rounding makes two scores equal.
+ *
+ * @return The indexes of the non-dominated candidates, in increasing order.
+ */
+std::vector<int> Electre::computeSkyline()
+{
+    orientValues();
+    std::vector<float> scores(nbCandidates, 0.0f);
+    for (int candidate = 0; candidate < nbCandidates; candidate++)
+    {
+        for (int criterium = 0; criterium < nbCriteria; criterium++)
         {
-            int start = cycle[linkIndex];
-            int end = (linkIndex + 1 < cycle.size()) ? cycle[linkIndex + 1] : cycle[0];
-            std::array<int, 2> link{start, end};
-            links.push_back(link);
+            scores[candidate] += oriented(candidate, criterium);
         }
+    }
 
-        // find the highest concordance values, and the link index
-        int highestConcordanceLinkIndex = 0;
-        float highestConcordanceValue = 0.0;
-        for (int i = 0; i < links.size(); i++)
+    std::vector<int> order(nbCandidates);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&scores](int a, int b)
+                     { return scores[a] > scores[b]; });
+
+    std::vector<int> window;
+    for (int candidate : order)
+    {
+        bool dominated = false;
+        for (int skylineCandidate : window)
         {
-            std::array<int, 2> link = links[i];
-            float concorValue = concordance[link[0]][link[1]];
-            if (concorValue > highestConcordanceValue)
+            if (paretoDominates(skylineCandidate, candidate))
             {
-                highestConcordanceValue = concorValue;
-                highestConcordanceLinkIndex = i;
+                dominated = true;
+                break;
             }
         }
+        if (dominated)
+            continue;
 
-        // delete the links
-        for (int i = 0; i < links.size(); i++)
-        {
-            if (i == highestConcordanceLinkIndex)
-                continue;
+        window.erase(std::remove_if(window.begin(), window.end(), [&](int skylineCandidate)
+                                    { return paretoDominates(candidate, skylineCandidate); }),
+                     window.end());
+        window.push_back(candidate);
+    }
 
-            std::array<int, 2> link = links[i];
-            dominance[link[0]][link[1]] = 0;
-        }
+    std::sort(window.begin(), window.end());
+    return window;
+}
+
+/**
+ * @brief Checks that the candidates pruned by the skyline pre-pass outrank no other candidate.
+ *
+ *  A pruned candidate without successor is on no cycle and no path between other candidates, so
+ *  the cycles of the skyline, and the order in which they are found, are those of all the
+ *  candidates. The edge from the skyline candidate that dominates it is then never deleted, and
+ *  keeps it out of the kernel: the kernel of the skyline is the kernel of all the candidates.
+ *
+ * @param skyline The candidates kept, in increasing order.
+ * @return true if no pruned candidate outranks another candidate.
+ */
+bool Electre::prunedOutrankNone(const std::vector<int> &skyline)
+{
+    std::vector<int> pruned;
+    size_t next = 0;
+    for (int candidate = 0; candidate < nbCandidates; candidate++)
+    {
+        if (next < skyline.size() && skyline[next] == candidate)
+            next++;
+        else
+            pruned.push_back(candidate);
     }
+
+    std::atomic<bool> outranks = false;
+    parallelFor(0, pruned.size(), [&](size_t first, size_t last)
+                {
+        for (size_t i = first; i < last && !outranks; i++)
+        {
+            int y = pruned[i];
+            for (int x = 0; x < nbCandidates; x++)
+            {
+                if (y == x)
+                    continue;
+                if (pairConcordance(y, x) < concordanceThreshold)
+                    continue;
+                if (!pairNonDiscordance(y, x))
+                    continue;
+                outranks = true;
+                break;
+            }
+        } });
+    return !outranks;
 }
 
 std::vector<bool> Electre::getKernel()
@@ -344,7 +794,9 @@ std::vector<bool> Electre::getKernel()
  */
 void Electre::setVetos(const std::vector<float> &newVetos)
 {
-    vetos = newVetos;
+    auto copy = cloneDataset();
+    copy->setVetos(newVetos);
+    setDataset(copy);
 }
 
 /**
@@ -354,11 +806,13 @@ void Electre::setVetos(const std::vector<float> &newVetos)
  */
 void Electre::setPreferenceThresholds(const std::vector<float> &newThresholds)
 {
+    auto copy = cloneDataset();
     if(newThresholds.empty()){
-        preferenceThresholds = std::vector<float>(nbCriteria, 0.0);
-        return;
+        copy->setPreferenceThresholds(std::vector<float>(nbCriteria, 0.0));
+    } else {
+        copy->setPreferenceThresholds(newThresholds);
     }
-    preferenceThresholds = newThresholds;
+    setDataset(copy);
 }
 
 /**
@@ -368,7 +822,9 @@ void Electre::setPreferenceThresholds(const std::vector<float> &newThresholds)
  */
 void Electre::setOptimizations(const std::vector<OptimizationType> &newOptimizations)
 {
-    optimizations = newOptimizations;
+    auto copy = cloneDataset();
+    copy->setOptimizations(newOptimizations);
+    setDataset(copy);
 }
 
 /**
@@ -378,7 +834,9 @@ void Electre::setOptimizations(const std::vector<OptimizationType> &newOptimizat
  */
 void Electre::setConcordanceThreshold(float newThreshold)
 {
-    concordanceThreshold = newThreshold;
+    auto copy = cloneDataset();
+    copy->setConcordanceThreshold(newThreshold);
+    setDataset(copy);
 }
 
 /**
@@ -409,6 +867,7 @@ void Electre::setNonDiscordanceMatrix(const std::vector<std::vector<bool>> &newN
 void Electre::setDominanceMatrix(const std::vector<std::vector<bool>> &newDominance)
 {
     dominance = newDominance;
+    useSparseGraph = false;
 }
 
 /**
@@ -423,41 +882,41 @@ void Electre::setKernel(const std::vector<bool> &newKernel)
 
 void Electre::printVectors()
 {
-    std::cout << "Printing corcordance: " << std::endl;
+    log() << "Printing corcordance: " << std::endl;
     for (std::vector<float> row : concordance) 
     {
         for (float val : row) 
         {
-            std::cout << val << "\t";
+            log() << val << "\t";
         }
-        std::cout << std::endl;
+        log() << std::endl;
     }
 
-    std::cout << "Printing non-discordance: " << std::endl;
+    log() << "Printing non-discordance: " << std::endl;
     for (std::vector<bool> row : nonDiscordance) 
     {
         for (bool val : row) 
         {
-            std::cout << val << "\t";
+            log() << val << "\t";
         }
-        std::cout << std::endl;
+        log() << std::endl;
     }
 
-    std::cout << "Printing dominance: " << std::endl;
+    log() << "Printing dominance: " << std::endl;
     for (std::vector<bool> row : dominance) 
     {
         for (bool val : row) 
         {
-            std::cout << val << "\t";
+            log() << val << "\t";
         }
-        std::cout << std::endl;
+        log() << std::endl;
     }
-    std::cout << "Printing kernel: " << std::endl;
+    log() << "Printing kernel: " << std::endl;
     for (bool val : kernel) 
     {
-        std::cout << val << "\t";
+        log() << val << "\t";
     }
-    std::cout << std::endl;
+    log() << std::endl;
 }
 
 
@@ -472,9 +931,12 @@ int Electre::save(std::string dirPath)
         }
     }
 
+    if (outputFormat != CSV) {
+        return saveArrays(folderPath);
+    }
 
     std::filesystem::path filePath = folderPath / "kernel.csv";
-    std::ofstream outputFileKernel(filePath);
+    CsvWriter outputFileKernel(filePath);
 
     if (!outputFileKernel) {
         std::cerr << "Error creating file for writing" << std::endl;
@@ -482,41 +944,490 @@ int Electre::save(std::string dirPath)
     }
 
     for (const auto& row : this->kernel) {
-        outputFileKernel << row << ",";
+        outputFileKernel << (bool)row << ',';
     }
 
-    outputFileKernel.close();
+    if (!outputFileKernel.close()) {
+        return -1;
+    }
 
     return 1;
 }
 
-void Electre::run()
+/**
+ * @brief Saves the results as binary arrays, see ArrayExport.
+ *
+ *  Besides the kernel, the concordance matrix and the bit-packed outranking relation are saved
+ *  when they were materialised: not by the out-of-core mode, and only for the skyline candidates
+ *  (listed in "candidates") after the skyline pre-pass.
+ *
+ * @param folderPath The Electre output directory.
+ * @return 1 on success, -1 if a file could not be written.
+ */
+int Electre::saveArrays(const std::filesystem::path &folderPath)
 {
-    std::cout << GREEN << "========== Starting Electre Algorithm ==========" << RESET << "\n";
+    ArrayExport arrays(folderPath, outputFormat, scheduler);
+    bool written = arrays.add("kernel", kernel);
 
+    size_t k = concordance.size();
+    bool materialised = k > 0 && nonDiscordance.size() == k && (k == (size_t)nbCandidates || k == skylineCandidates.size());
+    if (written && materialised)
+    {
+        if (k != (size_t)nbCandidates)
+            written = arrays.add("candidates", skylineCandidates);
+
+        written = written && arrays.addRows("concordance", "<f4", {k, k}, k * sizeof(float), [&](size_t row, uint8_t *destination)
+                                            { std::memcpy(destination, concordance[row].data(), k * sizeof(float)); });
+
+        // Recomputed from the matrixes: the dominance matrix itself lost the edges of the broken cycles
+        Json details = Json::object();
+        details["bitorder"] = "little";
+        details["logicalShape"] = Json::array(std::vector<size_t>{k, k});
+        details["description"] = "outranking relation before the cycles are broken";
+        size_t rowBytes = (k + 7) / 8;
+        written = written && arrays.addRows("dominance", "|u1", {k, rowBytes}, rowBytes, [&](size_t row, uint8_t *destination)
+                                            {
+            std::memset(destination, 0, rowBytes);
+            for (size_t x = 0; x < k; x++)
+            {
+                if (concordance[row][x] >= concordanceThreshold && nonDiscordance[row][x])
+                    destination[x / 8] |= 1 << (x % 8);
+            } }, details);
+    }
+
+    written = written && arrays.writeManifest(name);
+    return written ? 1 : -1;
+}
+
+/**
+ * @brief Describes the kernel of the last run.
+ *
+ * @return The size of the kernel over the number of candidates.
+ */
+std::string Electre::summary()
+{
+    if (kernel.empty())
+        return "no kernel";
+    return "kernel of " + std::to_string(std::count(kernel.begin(), kernel.end(), true)) + "/" + std::to_string(kernel.size()) + " candidates";
+}
+
+/**
+ * @brief Options that change the saved results.
+ *
+ *  The skyline pre-pass saves its candidates and matrixes over the skyline only, and an
+ *  out-of-core run saves no matrix at all.
+ *
+ * @return The memory limit and whether the skyline pre-pass is enabled.
+ */
+std::optional<std::string> Electre::cacheConfiguration() const
+{
+    return "mem-limit=" + std::to_string(memoryLimit) + ";skyline=" + (skylinePrefilter ? "1" : "0");
+}
+
+/**
+ * @brief Runs the four stages, on the skyline only when the pre-pass is enabled.
+ *
+ * @return false if the out-of-core run failed, the kernel is then empty.
+ */
+bool Electre::run(TaskScheduler &taskScheduler)
+{
+    scheduler = &taskScheduler;
+    log() << GREEN << "========== Starting Electre Algorithm ==========" << RESET << "\n";
+
+    // Optional step: keep only the candidates that can reach the kernel
+    std::shared_ptr<const Dataset> fullDataset;
+    skylineCandidates.clear();
+    if (skylinePrefilter)
+    {
+        log() << BLUE << "[Skyline]" << RESET << " Filtering Pareto-dominated candidates..." << std::endl;
+        ProfileScope stage("Electre/skyline");
+        if (!canUseSkyline())
+        {
+            log() << YELLOW << "⚠ Skyline pre-pass skipped: it requires non-negative vetos and a reachable concordance threshold." << RESET << "\n";
+        }
+        else
+        {
+            skylineCandidates = computeSkyline();
+            log() << GREEN << "✔ " << skylineCandidates.size() << "/" << nbCandidates << " candidates kept." << RESET << "\n";
+
+            // The stages below are run on the skyline only when the dominated candidates cannot
+            // change the kernel, otherwise on all the candidates
+            if (skylineCandidates.size() < (size_t)nbCandidates && !prunedOutrankNone(skylineCandidates))
+            {
+                log() << YELLOW << "⚠ Skyline pre-pass dropped: a dominated candidate outranks another one." << RESET << "\n";
+                skylineCandidates.clear();
+            }
+            else if (skylineCandidates.size() < (size_t)nbCandidates)
+            {
+                fullDataset = dataset;
+                setDataset(dataset->subset(skylineCandidates));
+                concordance.clear();
+                nonDiscordance.clear();
+                dominance.clear();
+                kernel.clear();
+            }
+        }
+    }
+
+    bool succeeded = true;
+    if (memoryLimit != 0 && inMemoryFootprint() > memoryLimit)
+        succeeded = runOutOfCore(fullDataset ? fullDataset->getStorageBytes() : 0);
+    else
+        runInMemory();
+
+    if (fullDataset && kernel.size() == (size_t)nbCandidates)
+    {
+        // Map the kernel back to the original candidates, dominated ones are never in it
+        std::vector<bool> fullKernel(fullDataset->getNbAlternatives(), false);
+        for (size_t i = 0; i < skylineCandidates.size(); i++)
+            fullKernel[skylineCandidates[i]] = kernel[i];
+        kernel = fullKernel;
+    }
+    if (fullDataset)
+        setDataset(fullDataset);
+
+    if (!succeeded)
+    {
+        log() << RED << "========== Electre Algorithm Failed ==========" << RESET << "\n";
+        return false;
+    }
+    log() << GREEN << "========== Electre Algorithm Completed ==========" << RESET << "\n";
+    return true;
+}
+
+/**
+ * @brief Runs the four Electre stages on full n×n matrixes.
+ */
+void Electre::runInMemory()
+{
     // Step 1: Process concordance matrix
-    std::cout << BLUE << "[Step 1/4]" << RESET << " Processing the concordance matrix..." << std::endl;
-    concordance.resize(values.size(), std::vector<float>(values.size(), 0.0));
+    log() << BLUE << "[Step 1/4]" << RESET << " Processing the concordance matrix..." << std::endl;
+    ProfileScope stage("Electre/concordance");
+    concordance.resize(nbCandidates, std::vector<float>(nbCandidates, 0.0));
     processConcordance();
-    std::cout << GREEN << "✔ Concordance matrix processed successfully." << RESET << "\n";
+    log() << GREEN << "✔ Concordance matrix processed successfully." << RESET << "\n";
 
     // Step 2: Process nondiscordance matrix
-    std::cout << BLUE << "[Step 2/4]" << RESET << " Processing the nondiscordance matrix..." << std::endl;
-    nonDiscordance.resize(values.size(), std::vector<bool>(values.size(), true));
+    log() << BLUE << "[Step 2/4]" << RESET << " Processing the nondiscordance matrix..." << std::endl;
+    stage.next("Electre/nondiscordance");
+    nonDiscordance.resize(nbCandidates, std::vector<bool>(nbCandidates, true));
     processNondiscordance();
-    std::cout << GREEN << "✔ Nondiscordance matrix processed successfully." << RESET << "\n";
+    log() << GREEN << "✔ Nondiscordance matrix processed successfully." << RESET << "\n";
 
     // Step 3: Compute dominance relations
-    std::cout << BLUE << "[Step 3/4]" << RESET << " Computing dominance relations..." << std::endl;
-    dominance.resize(values.size(), std::vector<bool>(values.size(), false));
+    log() << BLUE << "[Step 3/4]" << RESET << " Computing dominance relations..." << std::endl;
+    stage.next("Electre/dominance");
+    dominance.resize(nbCandidates, std::vector<bool>(nbCandidates, false));
     processDominance();
-    std::cout << GREEN << "✔ Dominance relations computed successfully." << RESET << "\n";
+    log() << GREEN << "✔ Dominance relations computed successfully." << RESET << "\n";
 
     // Step 4: Identify the kernel
-    std::cout << BLUE << "[Step 4/4]" << RESET << " Identifying the kernel (final decision set)..." << std::endl;
-    kernel.resize(values.size(), true);
+    log() << BLUE << "[Step 4/4]" << RESET << " Identifying the kernel (final decision set)..." << std::endl;
+    stage.next("Electre/kernel");
+    kernel.resize(nbCandidates, true);
     processKernel();
-    std::cout << GREEN << "✔ Kernel identified successfully." << RESET << "\n";
+    log() << GREEN << "✔ Kernel identified successfully." << RESET << "\n";
+}
 
-    std::cout << GREEN << "========== Electre Algorithm Completed ==========" << RESET << "\n";
+/**
+ * @brief Runs Electre without materialising any n×n matrix.
+ *
+ *  The dominance relation is computed in row-tiles that are compressed and spilled to the scratch
+ *  directory, then every graph stage streams those tiles back:
+ *  - candidates without predecessor or successor among the remaining ones cannot be part of a cycle
+ *    and are trimmed, pass after pass, which leaves a core that contains every cycle;
+ *  - an edge leaving or entering a trimmed candidate is never deleted by the cycle breaking, so it
+ *    removes its target from the kernel directly;
+ *  - the core is small enough to be solved in memory with the usual stages.
+ *
+ * @param retainedBytes Memory held outside this run, the full dataset after the skyline pre-pass.
+ * @return false if the memory limit is too low for the data or for the cyclic core, or if the
+ *         scratch file could not be written or read back.
+ */
+bool Electre::runOutOfCore(size_t retainedBytes)
+{
+    orientValues();
+    size_t n = nbCandidates;
+    // The values and their oriented copies, the full dataset kept by the skyline pre-pass, and the
+    // per-candidate degrees and core flags
+    size_t resident = dataset->getStorageBytes() + orientedCopies.size() + retainedBytes + n * (2 * sizeof(int) + 1);
+    if (memoryLimit <= resident)
+    {
+        std::cerr << "Error: --mem-limit is too low to hold the decision matrix (" << resident << " bytes needed)" << std::endl;
+        kernel.clear();
+        return false;
+    }
+    size_t budget = memoryLimit - resident;
+
+    TileStore store(scratchDirectory, n);
+    size_t wordsPerRow = store.getWordsPerRow();
+    // decoded tile + worst case encoded tile
+    size_t rowBytes = wordsPerRow * sizeof(uint64_t) * 5 / 2 + sizeof(uint64_t);
+    size_t tileRows = std::min(n, budget / rowBytes);
+    if (tileRows == 0)
+    {
+        std::cerr << "Error: --mem-limit is too low to hold a single dominance row (" << resident + rowBytes << " bytes needed)" << std::endl;
+        kernel.clear();
+        return false;
+    }
+
+    concordance.clear();
+    nonDiscordance.clear();
+    dominance.clear();
+
+    // Step 1: Compute the dominance tiles
+    log() << BLUE << "[Step 1/4]" << RESET << " Computing dominance tiles of " << tileRows << " rows out-of-core..." << std::endl;
+    ProfileScope stage("Electre/tiles");
+    std::vector<uint64_t> bits;
+    for (size_t firstRow = 0; firstRow < n; firstRow += tileRows)
+    {
+        size_t rowCount = std::min(tileRows, n - firstRow);
+        bits.assign(rowCount * wordsPerRow, 0);
+        parallelFor(0, rowCount, [&](size_t first, size_t last)
+                    {
+            for (size_t row = first; row < last; row++)
+            {
+                int y = firstRow + row;
+                for (int x = 0; x < (int)n; x++)
+                {
+                    if (y == x)
+                        continue;
+                    if (pairConcordance(y, x) < concordanceThreshold)
+                        continue;
+                    if (!pairNonDiscordance(y, x))
+                        continue;
+                    TileStore::setBit(bits.data() + row * wordsPerRow, x);
+                }
+            } });
+        if (!store.writeTile(firstRow, rowCount, bits))
+        {
+            kernel.clear();
+            return false;
+        }
+    }
+    if (!store.finish())
+    {
+        kernel.clear();
+        return false;
+    }
+    bits = std::vector<uint64_t>();
+    log() << GREEN << "✔ " << store.getTileCount() << " tiles spilled (" << store.getBytesWritten() << " bytes)." << RESET << "\n";
+
+    auto forEachSuccessor = [](const uint64_t *rowBits, size_t wordsPerRow, auto &&visit)
+    {
+        for (size_t word = 0; word < wordsPerRow; word++)
+        {
+            for (uint64_t remaining = rowBits[word]; remaining != 0; remaining &= remaining - 1)
+                visit(word * 64 + std::countr_zero(remaining));
+        }
+    };
+
+    // Step 2: Trim the candidates that cannot be part of a cycle
+    log() << BLUE << "[Step 2/4]" << RESET << " Trimming acyclic candidates..." << std::endl;
+    stage.next("Electre/trimming");
+    std::vector<bool> inCore(n, true);
+    std::vector<bool> upstream(n, false); // Trimmed without predecessor but with successors, may lead into the core
+    std::vector<int> inDegree(n), outDegree(n);
+    std::vector<uint64_t> buffer;
+    bool changed = true;
+    for (int round = 0; changed && round < MAX_TRIM_ROUNDS; round++)
+    {
+        std::fill(inDegree.begin(), inDegree.end(), 0);
+        std::fill(outDegree.begin(), outDegree.end(), 0);
+        bool streamed = store.stream(buffer, [&](size_t y, const uint64_t *rowBits)
+                                     {
+            if (!inCore[y])
+                return;
+            forEachSuccessor(rowBits, wordsPerRow, [&](size_t x)
+                             {
+                if (!inCore[x])
+                    return;
+                outDegree[y]++;
+                inDegree[x]++; }); });
+        if (!streamed)
+        {
+            kernel.clear();
+            return false;
+        }
+
+        changed = false;
+        for (size_t candidate = 0; candidate < n; candidate++)
+        {
+            if (inCore[candidate] && (inDegree[candidate] == 0 || outDegree[candidate] == 0))
+            {
+                inCore[candidate] = false;
+                upstream[candidate] = outDegree[candidate] > 0;
+                changed = true;
+            }
+        }
+    }
+    std::vector<int> core;
+    for (size_t candidate = 0; candidate < n; candidate++)
+    {
+        if (inCore[candidate])
+            core.push_back(candidate);
+    }
+    log() << GREEN << "✔ " << core.size() << " candidates left in the cyclic core." << RESET << "\n";
+
+    // Step 3: Solve the cyclic core in memory
+    log() << BLUE << "[Step 3/4]" << RESET << " Breaking the cycles of the core..." << std::endl;
+    stage.next("Electre/core");
+    std::vector<bool> outranked(n, false);
+    // The matrixes of the core, then its values and their oriented copies, each at most as floats
+    size_t coreBytes = core.size() * core.size() * sizeof(float) + core.size() * core.size() / 4 + 2 * core.size() * nbCriteria * sizeof(float);
+    if (coreBytes > budget)
+    {
+        std::cerr << "Error: --mem-limit is too low for the cyclic core (" << resident + coreBytes << " bytes needed)" << std::endl;
+        kernel.clear();
+        return false;
+    }
+    std::vector<int> searchOrder;
+    if (!core.empty() && !coreSearchOrder(store, inCore, upstream, resident + coreBytes, searchOrder))
+    {
+        kernel.clear();
+        return false;
+    }
+    if (!core.empty())
+    {
+        Electre coreElectre;
+        coreElectre.scheduler = scheduler;
+        coreElectre.setDataset(dataset->subset(core));
+        // Core indexes follow the original order
+        for (int &candidate : searchOrder)
+            candidate = std::lower_bound(core.begin(), core.end(), candidate) - core.begin();
+        coreElectre.cycleSearchOrder = std::move(searchOrder);
+        coreElectre.resetMatrixes();
+        coreElectre.processConcordance();
+        coreElectre.processNondiscordance();
+        coreElectre.processDominance();
+        coreElectre.processKernel();
+        for (size_t i = 0; i < core.size(); i++)
+        {
+            if (!coreElectre.kernel[i])
+                outranked[core[i]] = true;
+        }
+    }
+    log() << GREEN << "✔ Cyclic core processed successfully." << RESET << "\n";
+
+    // Step 4: Edges that touch a trimmed candidate are never deleted
+    log() << BLUE << "[Step 4/4]" << RESET << " Identifying the kernel (final decision set)..." << std::endl;
+    stage.next("Electre/kernel");
+    bool streamed = store.stream(buffer, [&](size_t y, const uint64_t *rowBits)
+                                 { forEachSuccessor(rowBits, wordsPerRow, [&](size_t x)
+                                                    {
+                if (!inCore[y] || !inCore[x])
+                    outranked[x] = true; }); });
+    if (!streamed)
+    {
+        kernel.clear();
+        return false;
+    }
+
+    kernel.assign(n, true);
+    for (size_t candidate = 0; candidate < n; candidate++)
+        kernel[candidate] = !outranked[candidate];
+    log() << GREEN << "✔ Kernel identified successfully." << RESET << "\n";
+    return true;
+}
+
+/**
+ * @brief Order in which the full cycle search would first reach the candidates of the core.
+ *
+ *  getCycles() starts from every candidate in index order, and a search started from a trimmed
+ *  candidate reaches the core through trimmed candidates only, since no path leaves the core and
+ *  comes back. Searching the core alone from its candidates in the order of their first visit
+ *  thus finds the same cycles, each in the same rotation, as the in-memory run: deleteCycles()
+ *  then keeps the same links. Only the edges out of the upstream candidates are loaded; a
+ *  candidate already visited is not searched again, its first visit already reached everything
+ *  that follows it.
+ *
+ * @param store The dominance tiles.
+ * @param inCore Whether each candidate belongs to the core.
+ * @param upstream Whether each trimmed candidate had successors when it was trimmed.
+ * @param used Bytes already needed by the run, for the memory limit.
+ * @param order Receives the core candidates, by original index, in the order of their first visit.
+ * @return false if the memory limit is too low or the tiles could not be read back.
+ */
+bool Electre::coreSearchOrder(const TileStore &store, const std::vector<bool> &inCore, const std::vector<bool> &upstream,
+                              size_t used, std::vector<int> &order)
+{
+    size_t n = nbCandidates;
+    size_t wordsPerRow = store.getWordsPerRow();
+    auto forEachTarget = [&](size_t y, const uint64_t *rowBits, auto &&visit)
+    {
+        if (!upstream[y])
+            return;
+        for (size_t word = 0; word < wordsPerRow; word++)
+        {
+            for (uint64_t remaining = rowBits[word]; remaining != 0; remaining &= remaining - 1)
+            {
+                size_t x = word * 64 + std::countr_zero(remaining);
+                if (inCore[x] || upstream[x])
+                    visit(x);
+            }
+        }
+    };
+
+    // Adjacency lists of the upstream candidates, counted then filled in row order
+    std::vector<uint64_t> buffer;
+    std::vector<size_t> offsets(n + 1, 0);
+    if (!store.stream(buffer, [&](size_t y, const uint64_t *rowBits)
+                      { forEachTarget(y, rowBits, [&](size_t)
+                                      { offsets[y + 1]++; }); }))
+        return false;
+    for (size_t y = 0; y < n; y++)
+        offsets[y + 1] += offsets[y];
+    // The edges, two offsets per candidate, and at worst every candidate on the search stack
+    size_t pathBytes = offsets[n] * sizeof(int) + n * (2 * sizeof(size_t) + sizeof(std::pair<int, size_t>)) + n / 8;
+    if (used + pathBytes > memoryLimit)
+    {
+        std::cerr << "Error: --mem-limit is too low for the paths into the cyclic core (" << used + pathBytes << " bytes needed)" << std::endl;
+        return false;
+    }
+    std::vector<int> targets(offsets[n]);
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    if (!store.stream(buffer, [&](size_t y, const uint64_t *rowBits)
+                      { forEachTarget(y, rowBits, [&](size_t x)
+                                      { targets[next[y]++] = x; }); }))
+        return false;
+    next = std::vector<size_t>();
+
+    // Depth-first search from every candidate in index order, with an explicit stack
+    std::vector<bool> visited(n, false);
+    std::vector<std::pair<int, size_t>> stack; // Candidate and its next edge
+    auto reach = [&](int candidate)
+    {
+        if (visited[candidate])
+            return;
+        visited[candidate] = true;
+        if (inCore[candidate])
+            order.push_back(candidate);
+        else if (upstream[candidate])
+            stack.push_back({candidate, offsets[candidate]});
+    };
+    order.clear();
+    for (size_t root = 0; root < n; root++)
+    {
+        reach(root);
+        while (!stack.empty())
+        {
+            auto &[candidate, edge] = stack.back();
+            if (edge == offsets[candidate + 1])
+                stack.pop_back();
+            else
+                reach(targets[edge++]);
+        }
+    }
+    return true;
 }
+
+/**
+ * @brief Estimates the memory needed by the in-memory stages.
+ *
+ * @return The size in bytes of the concordance, nondiscordance and dominance matrixes.
+ */
+size_t Electre::inMemoryFootprint()
+{
+    size_t n = nbCandidates;
+    return n * n * sizeof(float) + 2 * n * n / 8 + dataset->getStorageBytes();
+}
\ No newline at end of file
@@ -0,0 +1,429 @@
+#include "../include/Json.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    // Recursive descent over the text, pos always points to the next unread character
+    struct JsonReader
+    {
+        const std::string &text;
+        size_t pos = 0;
+        int depth = 0;
+
+        static constexpr int MAX_DEPTH = 64;
+
+        [[noreturn]] void fail(const std::string &message)
+        {
+            throw std::runtime_error("invalid JSON at offset " + std::to_string(pos) + ": " + message);
+        }
+
+        void skipSpaces()
+        {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+                pos++;
+        }
+
+        bool consume(const char *word)
+        {
+            size_t length = std::char_traits<char>::length(word);
+            if (text.compare(pos, length, word) != 0)
+                return false;
+            pos += length;
+            return true;
+        }
+
+        std::string readString()
+        {
+            std::string result;
+            pos++; // Opening quote
+            while (pos < text.size() && text[pos] != '"')
+            {
+                char c = text[pos++];
+                if (c != '\\')
+                {
+                    result += c;
+                    continue;
+                }
+                if (pos >= text.size())
+                    fail("unterminated escape");
+                char escaped = text[pos++];
+                switch (escaped)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    result += escaped;
+                    break;
+                case 'b':
+                    result += '\b';
+                    break;
+                case 'f':
+                    result += '\f';
+                    break;
+                case 'n':
+                    result += '\n';
+                    break;
+                case 'r':
+                    result += '\r';
+                    break;
+                case 't':
+                    result += '\t';
+                    break;
+                case 'u':
+                {
+                    unsigned code = 0;
+                    if (pos + 4 > text.size() || std::from_chars(text.data() + pos, text.data() + pos + 4, code, 16).ptr != text.data() + pos + 4)
+                        fail("invalid \\u escape");
+                    pos += 4;
+                    // Encoded as UTF-8, surrogate pairs are not combined
+                    if (code < 0x80)
+                    {
+                        result += (char)code;
+                    }
+                    else if (code < 0x800)
+                    {
+                        result += (char)(0xC0 | (code >> 6));
+                        result += (char)(0x80 | (code & 0x3F));
+                    }
+                    else
+                    {
+                        result += (char)(0xE0 | (code >> 12));
+                        result += (char)(0x80 | ((code >> 6) & 0x3F));
+                        result += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default:
+                    fail("invalid escape");
+                }
+            }
+            if (pos >= text.size())
+                fail("unterminated string");
+            pos++; // Closing quote
+            return result;
+        }
+
+        Json readValue()
+        {
+            skipSpaces();
+            if (pos >= text.size())
+                fail("unexpected end");
+            if (++depth > MAX_DEPTH)
+                fail("nested too deeply");
+
+            Json value;
+            char c = text[pos];
+            if (c == '{')
+            {
+                value = Json::object();
+                pos++;
+                skipSpaces();
+                if (pos < text.size() && text[pos] == '}')
+                {
+                    pos++;
+                }
+                else
+                {
+                    while (true)
+                    {
+                        skipSpaces();
+                        if (pos >= text.size() || text[pos] != '"')
+                            fail("expected a key");
+                        std::string key = readString();
+                        skipSpaces();
+                        if (pos >= text.size() || text[pos++] != ':')
+                            fail("expected ':'");
+                        value[key] = readValue();
+                        skipSpaces();
+                        if (pos < text.size() && text[pos] == ',')
+                        {
+                            pos++;
+                            continue;
+                        }
+                        if (pos < text.size() && text[pos] == '}')
+                        {
+                            pos++;
+                            break;
+                        }
+                        fail("expected ',' or '}'");
+                    }
+                }
+            }
+            else if (c == '[')
+            {
+                value = Json::array();
+                pos++;
+                skipSpaces();
+                if (pos < text.size() && text[pos] == ']')
+                {
+                    pos++;
+                }
+                else
+                {
+                    while (true)
+                    {
+                        value.push(readValue());
+                        skipSpaces();
+                        if (pos < text.size() && text[pos] == ',')
+                        {
+                            pos++;
+                            continue;
+                        }
+                        if (pos < text.size() && text[pos] == ']')
+                        {
+                            pos++;
+                            break;
+                        }
+                        fail("expected ',' or ']'");
+                    }
+                }
+            }
+            else if (c == '"')
+            {
+                value = Json(readString());
+            }
+            else if (consume("true"))
+            {
+                value = Json(true);
+            }
+            else if (consume("false"))
+            {
+                value = Json(false);
+            }
+            else if (consume("null"))
+            {
+                value = Json();
+            }
+            else
+            {
+                double number = 0;
+                auto [end, error] = std::from_chars(text.data() + pos, text.data() + text.size(), number);
+                if (error != std::errc() || end == text.data() + pos)
+                    fail("unexpected character");
+                pos = end - text.data();
+                value = Json(number);
+            }
+            depth--;
+            return value;
+        }
+    };
+}
+
+/**
+ * @brief Parses a JSON document.
+ *
+ * @param text The document.
+ * @return The root value.
+ */
+Json Json::parse(const std::string &text)
+{
+    JsonReader reader{text};
+    Json value = reader.readValue();
+    reader.skipSpaces();
+    if (reader.pos != text.size())
+        reader.fail("trailing characters");
+    return value;
+}
+
+/**
+ * @brief Serializes the value on a single line.
+ *
+ * @return The JSON text.
+ */
+std::string Json::dump() const
+{
+    std::string out;
+    dump(out);
+    return out;
+}
+
+void Json::dump(std::string &out) const
+{
+    switch (type)
+    {
+    case NUL:
+        out += "null";
+        break;
+    case BOOLEAN:
+        out += boolean ? "true" : "false";
+        break;
+    case NUMBER:
+    {
+        if (!std::isfinite(number))
+        {
+            out += "null";
+            break;
+        }
+        char buffer[32];
+        auto result = isFloat ? std::to_chars(buffer, buffer + sizeof(buffer), (float)number)
+                              : std::to_chars(buffer, buffer + sizeof(buffer), number);
+        out.append(buffer, result.ptr);
+        break;
+    }
+    case STRING:
+        out += '"';
+        for (char c : string)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if (c == '\n')
+            {
+                out += "\\n";
+            }
+            else if ((unsigned char)c < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+        out += '"';
+        break;
+    case ARRAY:
+        out += '[';
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            if (i != 0)
+                out += ',';
+            items[i].dump(out);
+        }
+        out += ']';
+        break;
+    case OBJECT:
+        out += '{';
+        for (size_t i = 0; i < members.size(); i++)
+        {
+            if (i != 0)
+                out += ',';
+            Json(members[i].first).dump(out);
+            out += ':';
+            members[i].second.dump(out);
+        }
+        out += '}';
+        break;
+    }
+}
+
+bool Json::asBool() const
+{
+    if (type != BOOLEAN)
+        throw std::runtime_error("expected a boolean");
+    return boolean;
+}
+
+double Json::asNumber() const
+{
+    if (type != NUMBER)
+        throw std::runtime_error("expected a number");
+    return number;
+}
+
+const std::string &Json::asString() const
+{
+    if (type != STRING)
+        throw std::runtime_error("expected a string");
+    return string;
+}
+
+const std::vector<Json> &Json::asArray() const
+{
+    if (type != ARRAY)
+        throw std::runtime_error("expected an array");
+    return items;
+}
+
+const std::vector<std::pair<std::string, Json>> &Json::asObject() const
+{
+    if (type != OBJECT)
+        throw std::runtime_error("expected an object");
+    return members;
+}
+
+/**
+ * @brief Reads an array of numbers.
+ *
+ * @return The numbers as floats.
+ */
+std::vector<float> Json::asFloats() const
+{
+    std::vector<float> values;
+    for (const Json &item : asArray())
+        values.push_back(item.asNumber());
+    return values;
+}
+
+bool Json::contains(const std::string &key) const
+{
+    if (type != OBJECT)
+        return false;
+    for (const auto &member : members)
+    {
+        if (member.first == key)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Reads a member of an object.
+ *
+ * @param key The name of the member.
+ * @return The member, or null when it is missing.
+ */
+const Json &Json::operator[](const std::string &key) const
+{
+    static const Json missing;
+    if (type != OBJECT)
+        throw std::runtime_error("expected an object");
+    for (const auto &member : members)
+    {
+        if (member.first == key)
+            return member.second;
+    }
+    return missing;
+}
+
+/**
+ * @brief Accesses a member of an object, adding it when it is missing.
+ *
+ * @param key The name of the member.
+ * @return The member.
+ */
+Json &Json::operator[](const std::string &key)
+{
+    if (type == NUL)
+        type = OBJECT;
+    if (type != OBJECT)
+        throw std::runtime_error("expected an object");
+    for (auto &member : members)
+    {
+        if (member.first == key)
+            return member.second;
+    }
+    members.emplace_back(key, Json());
+    return members.back().second;
+}
+
+/**
+ * @brief Appends a value to an array.
+ *
+ * @param value The value to append.
+ */
+void Json::push(Json value)
+{
+    if (type == NUL)
+        type = ARRAY;
+    if (type != ARRAY)
+        throw std::runtime_error("expected an array");
+    items.push_back(std::move(value));
+}
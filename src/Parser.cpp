@@ -1,7 +1,10 @@
 #include "../include/Parser.hpp"
+#include "../include/Json.hpp"
+#include <functional>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 /**
  * @brief Constructs a new Parser object.
@@ -10,7 +13,22 @@
  *
  * @param delimiter The character used to separate values in input strings.
  */
-Parser::Parser(char delimiter) : m_delimiter(delimiter) {}
+Parser::Parser(char delimiter) : m_delimiter(delimiter), dataset(std::make_shared<Dataset>()) {}
+
+/**
+ * @brief Gives write access to the dataset being built.
+ *
+ *  Once the dataset has been handed out by getDataset(), it is copied before being modified so the
+ *  algorithms borrowing it never see it change. The copy shares the values.
+ *
+ * @return The dataset owned by the parser.
+ */
+Dataset &Parser::editDataset()
+{
+    if (dataset.use_count() > 1)
+        dataset = std::make_shared<Dataset>(*dataset);
+    return *dataset;
+}
 
 /**
  * @brief Splits a string into a vector of unsigned 16-bit integers.
@@ -56,36 +74,65 @@ std::vector<OptimizationType> Parser::splitOptimization(const std::string &s)
     return tokens;
 }
 
+/**
+ * @brief Counts the distinct values of one criterion line.
+ *
+ *  Stops counting once more than MAX_TRACKED_LEVELS distinct values are seen, so the
+ *  cost stays linear in the line length for high-cardinality criteria.
+ *
+ * @param line The values of one criterion across all alternatives.
+ * @return The number of distinct values, capped at MAX_TRACKED_LEVELS + 1.
+ */
+size_t Parser::countLevels(std::span<const float> line)
+{
+    std::vector<float> levels;
+    for (float value : line)
+    {
+        auto it = std::lower_bound(levels.begin(), levels.end(), value);
+        if (it != levels.end() && *it == value)
+            continue;
+
+        levels.insert(it, value);
+        if (levels.size() > MAX_TRACKED_LEVELS)
+            break;
+    }
+    return levels.size();
+}
+
 /**
  * @brief Parses a file containing data separated by a delimiter.
  *
  *  Reads the contents of the specified file, splits each line into a vector of unsigned 16-bit
- *  integers based on the delimiter, and stores the resulting vectors in the `parsedFile`
- *  member variable.
+ *  integers based on the delimiter, and stores the values in the dataset. Each line holds one
+ *  criterion for all the alternatives and is appended as is, the dataset being stored criterion by
+ *  criterion. The number of distinct values of every criterion is recorded along the way.
  *
  * @param filename The path to the file to be parsed.
  */
 void Parser::parseFile(const std::string &filename)
 {
-    std::cout << "Parsed Starting" << std::endl;
+    *output << "Parsed Starting" << std::endl;
 
-    std::vector<std::vector<float>> result;
+    std::vector<float> values;
+    std::vector<size_t> cardinalities;
+    size_t nbAlternatives = 0;
     std::string line;
     std::ifstream file(filename);
     if (file.is_open())
     {
-        bool first = true;
         while (std::getline(file, line))
         {
             std::vector<float> tempVector = split(line);
-            for (int i = 0; i <  tempVector.size(); i++) {
-                if (first) {
-                    std::vector<float> toto;
-                    result.push_back(toto);
-                }
-                result[i].push_back(tempVector[i]);
+            if (cardinalities.empty())
+                nbAlternatives = tempVector.size();
+            if (tempVector.size() != nbAlternatives)
+            {
+                std::cerr << "Error: " << filename << " line " << cardinalities.size() + 1 << " has " << tempVector.size()
+                          << " values instead of " << nbAlternatives << std::endl;
+                tempVector.resize(nbAlternatives, 0);
             }
-            first = false;
+            cardinalities.push_back(countLevels(tempVector));
+            values.insert(values.end(), tempVector.begin(), tempVector.end());
         }
         file.close();
     }
@@ -93,9 +140,11 @@ void Parser::parseFile(const std::string &filename)
     {
         std::cerr << "Error: " << filename << std::endl;
     }
-    std::cout << "Data Parsed" << std::endl;
+    *output << "Data Parsed" << std::endl;
 
-    this->parsedFile = result;
+    Dataset &edited = editDataset();
+    edited.setValues(nbAlternatives, cardinalities.size(), std::move(values));
+    edited.setCriterionCardinalities(cardinalities);
 }
 
 /**
@@ -103,7 +152,7 @@ void Parser::parseFile(const std::string &filename)
  *
  *  Reads the contents of the specified file, splits each line into a vector of floating-point
  *  numbers based on the delimiter, and stores the resulting vectors in the
- *  `parsedWeightFile` member variable.
+ *  weights of the dataset.
  *
  * @param filename The path to the file to be parsed.
  */
@@ -127,7 +176,7 @@ void Parser::parseWeightFile(const std::string &filename)
     for(int i = 0; i < result[0].size(); i++) {
         result[0][i] = result[0][i] / total_weight;
     }
-    this->parsedWeightFile = result[0];
+    editDataset().setWeights(result[0]);
 }
 
 void Parser::parseVetosFile(const std::string &filename)
@@ -146,7 +195,7 @@ void Parser::parseVetosFile(const std::string &filename)
     }
     file.close();
 
-    this->parsedVetosFile = result[0];
+    editDataset().setVetos(result[0]);
 }
 
 void Parser::parsePreferencesFile(const std::string &filename)
@@ -165,7 +214,7 @@ void Parser::parsePreferencesFile(const std::string &filename)
     }
     file.close();
 
-    this->parsedPreferencesFile = result[0];
+    editDataset().setPreferenceThresholds(result[0]);
 }
 
 void Parser::parseOptimizationsFile(const std::string &filename)
@@ -184,7 +233,7 @@ void Parser::parseOptimizationsFile(const std::string &filename)
     }
     file.close();
 
-    this->parsedOptimizationsFile = result[0];
+    editDataset().setOptimizations(result[0]);
 }
 
 void Parser::parseConcordanceThresholdFile(const std::string &filename)
@@ -203,23 +252,156 @@ void Parser::parseConcordanceThresholdFile(const std::string &filename)
     }
     file.close();
 
-    this->parsedConcordanceThresholdFile = result[0];
+    editDataset().setConcordanceThreshold(result[0]);
+}
+
+/**
+ * @brief Parses the criteria hierarchy of a label.json file.
+ *
+ *  The file nests objects of groups down to arrays of criterion names, in the order of the
+ *  criteria in the data file, and names its levels in "label", e.g. Catégories → Thèmes →
+ *  Critères. An optional "weights" object gives, per level label, the weight of some of its
+ *  groups or criteria, the others weighing 1:
+ *
+ *      "weights": { "Catégories": { "Economie": 2 }, "Critères": { "Pente": 0.5 } }
+ *
+ *  When no weight file was parsed before, the weight of each criterion is derived as the product,
+ *  down its path, of each node's weight divided by the total weight of its siblings.
+ *
+ * @param filename The path to the label.json file.
+ */
+void Parser::parseHierarchyFile(const std::string &filename)
+{
+    std::vector<CriterionLevel> levels;
+    std::vector<float> derivedWeights;
+    try
+    {
+        std::ifstream file(filename);
+        if (!file.is_open())
+            throw std::runtime_error("cannot be opened");
+        std::stringstream text;
+        text << file.rdbuf();
+        Json root = Json::parse(text.str());
+
+        std::vector<std::string> labels;
+        if (root.contains("label"))
+        {
+            for (const Json &label : root["label"].asArray())
+                labels.push_back(label.asString());
+        }
+        auto levelLabel = [&](size_t depth)
+        { return depth < labels.size() ? labels[depth] : "Level " + std::to_string(depth + 1); };
+        auto weightOf = [&](size_t depth, const std::string &name)
+        {
+            if (!root.contains("weights") || !root["weights"].contains(levelLabel(depth)))
+                return 1.0;
+            const Json &weights = root["weights"][levelLabel(depth)];
+            return weights.contains(name) ? weights[name].asNumber() : 1.0;
+        };
+
+        // Depth-first, keeping the group of every level above the current node
+        int criteriaDepth = -1;
+        std::vector<int> path;
+        std::function<void(const Json &, size_t, double)> walk = [&](const Json &node, size_t depth, double weight)
+        {
+            if (node.getType() == Json::ARRAY)
+            {
+                if (criteriaDepth >= 0 && (size_t)criteriaDepth != depth)
+                    throw std::runtime_error("the criteria are not all at the same depth");
+                criteriaDepth = depth;
+                double total = 0;
+                for (const Json &criterion : node.asArray())
+                    total += weightOf(depth, criterion.asString());
+                for (const Json &criterion : node.asArray())
+                {
+                    derivedWeights.push_back(total > 0 ? weight * weightOf(depth, criterion.asString()) / total : 0);
+                    for (size_t level = 0; level < depth; level++)
+                        levels[level].groupOf.push_back(path[level]);
+                }
+                return;
+            }
+
+            const auto &members = node.asObject();
+            double total = 0;
+            for (const auto &[name, child] : members)
+            {
+                if (depth > 0 || (name != "label" && name != "weights"))
+                    total += weightOf(depth, name);
+            }
+            if (levels.size() <= depth)
+                levels.push_back({levelLabel(depth), {}, {}});
+            for (const auto &[name, child] : members)
+            {
+                if (depth == 0 && (name == "label" || name == "weights"))
+                    continue;
+                path.resize(depth);
+                path.push_back(levels[depth].groups.size());
+                levels[depth].groups.push_back(name);
+                walk(child, depth + 1, total > 0 ? weight * weightOf(depth, name) / total : 0);
+            }
+        };
+        walk(root, 0, 1.0);
+
+        size_t nbCriteria = dataset->getNbCriteria();
+        if (nbCriteria > 0 && derivedWeights.size() != nbCriteria)
+            throw std::runtime_error("lists " + std::to_string(derivedWeights.size()) + " criteria instead of " + std::to_string(nbCriteria));
+        levels.resize(std::max(criteriaDepth, 0));
+    }
+    catch (const std::exception &exception)
+    {
+        std::cerr << "Error: " << filename << ": " << exception.what() << std::endl;
+        return;
+    }
+
+    Dataset &edited = editDataset();
+    edited.setHierarchy(levels);
+    if (edited.getWeights().empty())
+        edited.setWeights(derivedWeights);
+}
+
+/**
+ * @brief Parses every file of a dataset directory that exists.
+ *
+ *  A dataset directory holds `donnees.csv`, `weight.csv` (or `poids.csv`), `vetos.csv`,
+ *  `optimizations.csv`, `preferences.csv` and `seuilconcordance.csv`, like `data/cars`, and
+ *  optionally the criteria hierarchy `label.json`, like `data/recycle`.
+ *
+ * @param directory The path to the dataset directory.
+ * @param withData false to leave `donnees.csv` unread.
+ */
+void Parser::parseDirectory(const std::filesystem::path &directory, bool withData)
+{
+    if (withData)
+        parseFile(directory / "donnees.csv");
+    if (std::filesystem::exists(directory / "weight.csv"))
+        parseWeightFile(directory / "weight.csv");
+    else if (std::filesystem::exists(directory / "poids.csv"))
+        parseWeightFile(directory / "poids.csv");
+    if (std::filesystem::exists(directory / "vetos.csv"))
+        parseVetosFile(directory / "vetos.csv");
+    if (std::filesystem::exists(directory / "optimizations.csv"))
+        parseOptimizationsFile(directory / "optimizations.csv");
+    if (std::filesystem::exists(directory / "seuilconcordance.csv"))
+        parseConcordanceThresholdFile(directory / "seuilconcordance.csv");
+    if (std::filesystem::exists(directory / "preferences.csv"))
+        parsePreferencesFile(directory / "preferences.csv");
+    if (std::filesystem::exists(directory / "label.json"))
+        parseHierarchyFile(directory / "label.json");
 }
 
 /**
  * @brief Prints the parsed data to the console.
  *
- *  Iterates through the `parsedFile` member variable and prints each row of data,
- *  separated by commas.
+ *  Prints the values of each alternative on one line, separated by commas.
  */
 void Parser::print() const
 {
-    for (const auto &row : parsedFile)
+    for (size_t alternative = 0; alternative < dataset->getNbAlternatives(); ++alternative)
     {
-        for (size_t i = 0; i < row.size(); ++i)
+        for (size_t i = 0; i < dataset->getNbCriteria(); ++i)
         {
-            std::cout << row[i];
-            if (i != row.size() - 1)
+            std::cout << dataset->value(alternative, i);
+            if (i != dataset->getNbCriteria() - 1)
             {
                 std::cout << ", ";
             }
@@ -231,34 +413,56 @@ void Parser::print() const
 /**
  * @brief Returns the parsed file data.
  *
- * @return The `parsedFile` member variable containing the parsed data as a vector of vectors.
+ * @return A copy of the parsed data as one vector per alternative.
  */
 std::vector<std::vector<float>> Parser::getParsedFile()
 {
-    return parsedFile;
+    return dataset->toRows();
 }
 
 std::vector<float> Parser::getParsedWeight()
 {
-    return parsedWeightFile;
+    std::span<const float> weights = dataset->getWeights();
+    return std::vector<float>(weights.begin(), weights.end());
 }
 
 std::vector<float> Parser::getParsedVetosFile()
 {
-    return parsedVetosFile;
+    std::span<const float> vetos = dataset->getVetos();
+    return std::vector<float>(vetos.begin(), vetos.end());
 }
 
 std::vector<float> Parser::getParsedPreferencesFile()
 {
-    return parsedPreferencesFile;
+    std::span<const float> preferences = dataset->getPreferenceThresholds();
+    return std::vector<float>(preferences.begin(), preferences.end());
 }
 
 std::vector<OptimizationType> Parser::getParsedOptimizationsFile()
 {
-    return parsedOptimizationsFile;
+    std::span<const OptimizationType> optimizations = dataset->getOptimizations();
+    return std::vector<OptimizationType>(optimizations.begin(), optimizations.end());
 }
 
 float Parser::getParsedConcordanceThresholdFile()
 {
-    return parsedConcordanceThresholdFile;
+    return dataset->getConcordanceThreshold();
+}
+
+std::vector<size_t> Parser::getParsedCriterionCardinalities()
+{
+    std::span<const size_t> cardinalities = dataset->getCriterionCardinalities();
+    return std::vector<size_t>(cardinalities.begin(), cardinalities.end());
+}
+
+/**
+ * @brief Returns the dataset built from all the parsed files.
+ *
+ *  The dataset is shared, not copied: every algorithm borrows the same values.
+ *
+ * @return The parsed dataset.
+ */
+std::shared_ptr<const Dataset> Parser::getDataset()
+{
+    return dataset;
 }
@@ -0,0 +1,330 @@
+#include "../include/Profiler.hpp"
+#include "../include/Json.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    struct CounterSpec
+    {
+        const char *name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+    constexpr CounterSpec HARDWARE_COUNTERS[] = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"llcMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"branchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+
+    constexpr CounterSpec SOFTWARE_COUNTERS[] = {
+        {"taskClockNs", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+        {"pageFaults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+        {"contextSwitches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}};
+
+    // Counts the calling thread and every thread it starts afterwards, the hardware events in user space only
+    int openCounter(const CounterSpec &spec)
+    {
+        perf_event_attr attributes{};
+        attributes.size = sizeof(attributes);
+        attributes.type = spec.type;
+        attributes.config = spec.config;
+        attributes.inherit = 1;
+        attributes.exclude_kernel = spec.type == PERF_TYPE_HARDWARE;
+        attributes.exclude_hv = spec.type == PERF_TYPE_HARDWARE;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+    }
+#endif
+}
+
+/**
+ * @brief Reads the clocks and counters.
+ *
+ * @return The current resource usage of the process.
+ */
+Profiler::Snapshot Profiler::snapshot()
+{
+    timespec cpu{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    return {std::chrono::steady_clock::now(), cpu.tv_sec * 1e3 + cpu.tv_nsec / 1e6,
+            allocationCount.load(std::memory_order_relaxed), allocationBytes.load(std::memory_order_relaxed),
+            readCounters()};
+}
+
+/**
+ * @brief Opens the hardware counters, or the software ones if any hardware counter is missing.
+ *
+ *  Must be called before the worker threads are started, only these inherit the counters.
+ */
+void Profiler::openCounters()
+{
+#ifdef __linux__
+    auto openAll = [](const auto &specs) -> int
+    {
+        counterCount = 0;
+        for (const CounterSpec &spec : specs)
+        {
+            int fd = openCounter(spec);
+            if (fd < 0)
+            {
+                int error = errno;
+                closeCounters();
+                return error;
+            }
+            counterFds[counterCount] = fd;
+            counterNames[counterCount++] = spec.name;
+        }
+        return 0;
+    };
+
+    int error = openAll(HARDWARE_COUNTERS);
+    if (error == 0)
+    {
+        counterSource = "hardware";
+        return;
+    }
+    counterNote = std::string("hardware counters unavailable (") + std::strerror(error) + ")";
+    error = openAll(SOFTWARE_COUNTERS);
+    if (error == 0)
+    {
+        counterSource = "software";
+        return;
+    }
+    counterNote += std::string(", software counters unavailable (") + std::strerror(error) + ")";
+#else
+    counterNote = "perf_event is only available on Linux";
+#endif
+    counterSource = "clock";
+}
+
+void Profiler::closeCounters()
+{
+    for (size_t i = 0; i < counterCount; i++)
+    {
+        close(counterFds[i]);
+        counterNames[i] = nullptr;
+    }
+    counterCount = 0;
+}
+
+/**
+ * @brief Reads the open counters, scaled up when the kernel had to multiplex them.
+ *
+ * @return The values, in the order of counterNames.
+ */
+Profiler::CounterValues Profiler::readCounters()
+{
+    CounterValues values{};
+    for (size_t i = 0; i < counterCount; i++)
+    {
+        uint64_t buffer[3]; // value, time enabled, time running
+        if (read(counterFds[i], buffer, sizeof(buffer)) != sizeof(buffer))
+            continue;
+        values[i] = buffer[2] == 0 || buffer[2] == buffer[1] ? buffer[0] : (uint64_t)((double)buffer[0] * buffer[1] / buffer[2]);
+    }
+    return values;
+}
+
+/**
+ * @brief Records a finished stage.
+ *
+ * @param name The name of the stage, e.g. "Electre/concordance".
+ * @param start The snapshot taken when the stage started.
+ */
+void Profiler::record(const std::string &name, const Snapshot &start)
+{
+    Snapshot now = snapshot();
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    Stage stage{name,
+                std::chrono::duration<double, std::milli>(start.wall - origin.wall).count(),
+                std::chrono::duration<double, std::milli>(now.wall - start.wall).count(),
+                now.cpuMs - start.cpuMs,
+                now.allocations - start.allocations,
+                now.allocatedBytes - start.allocatedBytes,
+                usage.ru_maxrss,
+                {}};
+    for (size_t i = 0; i < counterCount; i++)
+        stage.counters[i] = now.counters[i] - start.counters[i];
+    std::lock_guard<std::mutex> lock(stagesMutex);
+    stages.push_back(stage);
+}
+
+/**
+ * @brief Writes the recorded stages as JSON.
+ *
+ * @param path The report file.
+ * @param command The command line of the run.
+ * @return false if the file could not be written.
+ */
+bool Profiler::writeReport(const std::string &path, const std::string &command)
+{
+    Snapshot now = snapshot();
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    Json report = Json::object();
+    report["command"] = command;
+    report["wallMs"] = std::chrono::duration<double, std::milli>(now.wall - origin.wall).count();
+    report["cpuMs"] = now.cpuMs - origin.cpuMs;
+    report["allocations"] = (size_t)(now.allocations - origin.allocations);
+    report["allocatedBytes"] = (size_t)(now.allocatedBytes - origin.allocatedBytes);
+    report["peakRssKb"] = (size_t)usage.ru_maxrss;
+    report["counterSource"] = counterSource;
+    if (!counterNote.empty())
+        report["counterNote"] = counterNote;
+
+    auto counterObject = [](const CounterValues &values)
+    {
+        Json counters = Json::object();
+        for (size_t i = 0; i < counterCount; i++)
+            counters[counterNames[i]] = (size_t)values[i];
+        return counters;
+    };
+    CounterValues total{};
+    for (size_t i = 0; i < counterCount; i++)
+        total[i] = now.counters[i] - origin.counters[i];
+    report["counters"] = counterObject(total);
+
+    Json stageList = Json::array();
+    {
+        std::lock_guard<std::mutex> lock(stagesMutex);
+        for (const Stage &stage : stages)
+        {
+            Json entry = Json::object();
+            entry["name"] = stage.name;
+            entry["startMs"] = stage.startMs;
+            entry["wallMs"] = stage.wallMs;
+            entry["cpuMs"] = stage.cpuMs;
+            entry["allocations"] = (size_t)stage.allocations;
+            entry["allocatedBytes"] = (size_t)stage.allocatedBytes;
+            entry["peakRssKb"] = (size_t)stage.peakRssKb;
+            entry["counters"] = counterObject(stage.counters);
+            stageList.push(entry);
+        }
+    }
+    report["stages"] = stageList;
+
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Error: " << path << std::endl;
+        return false;
+    }
+    file << report.dump() << "\n";
+    return true;
+}
+
+void ProfileScope::begin(const char *stageName)
+{
+    name = stageName;
+    start = Profiler::snapshot();
+}
+
+void ProfileScope::end()
+{
+    Profiler::record(name, start);
+    name = nullptr;
+}
+
+ProfileSession::ProfileSession(const std::string &path, const std::string &command) : path(path), command(command)
+{
+    if (path.empty())
+        return;
+    Profiler::openCounters();
+    if (Profiler::counterSource != "hardware")
+        std::cerr << "⚠️ Warning: " << Profiler::counterNote << ", profiling with "
+                  << (Profiler::counterSource == "software" ? "software counters" : "the process clocks only") << " ⚠️\n";
+    Profiler::origin = Profiler::snapshot();
+    Profiler::enabled.store(true);
+}
+
+ProfileSession::~ProfileSession()
+{
+    if (path.empty())
+        return;
+    Profiler::enabled.store(false);
+    Profiler::writeReport(path, command);
+    Profiler::closeCounters();
+}
+
+// Counting allocator: a single flag test when profiling is off. Every variant is replaced, the
+// standard library mixes them (e.g. std::stable_sort takes its buffer with the nothrow new and
+// releases it with the plain delete), and all of them must agree on malloc and free.
+namespace
+{
+    // Returns nullptr once the new handler gives up, alignment 0 for the default alignment
+    void *allocate(std::size_t size, std::size_t alignment)
+    {
+        if (Profiler::enabled.load(std::memory_order_relaxed))
+        {
+            Profiler::allocationCount.fetch_add(1, std::memory_order_relaxed);
+            Profiler::allocationBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+        if (size == 0)
+            size = 1;
+        while (true)
+        {
+            // aligned_alloc needs a multiple of the alignment
+            void *pointer = alignment == 0 ? std::malloc(size)
+                                           : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+            if (pointer)
+                return pointer;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                return nullptr;
+            try
+            {
+                handler();
+            }
+            catch (const std::bad_alloc &)
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    void *allocateOrThrow(std::size_t size, std::size_t alignment)
+    {
+        if (void *pointer = allocate(size, alignment))
+            return pointer;
+        throw std::bad_alloc();
+    }
+}
+
+void *operator new(std::size_t size) { return allocateOrThrow(size, 0); }
+void *operator new[](std::size_t size) { return allocateOrThrow(size, 0); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return allocate(size, 0); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return allocate(size, 0); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, std::size_t(alignment)); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, std::size_t(alignment)); }
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return allocate(size, std::size_t(alignment)); }
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return allocate(size, std::size_t(alignment)); }
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t &) noexcept { std::free(pointer); }
@@ -1,4 +1,20 @@
 #include "../include/Promethee.hpp"
+#include "../include/Parser.hpp"
+#include "../include/BlockingQueue.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/CsvWriter.hpp"
+#include "../include/ArrayExport.hpp"
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <sstream>
 
 #define RESET "\033[0m"
 #define RED "\033[31m"
@@ -15,10 +31,10 @@
  * @param data A 2D vector where each row represents an alternative and each column represents a criterion.
  * @param weights A vector representing the weights for each criterion.
  */
-Promethee::Promethee(std::vector<std::vector<float>> data, std::vector<float> weights) : Promethee()
+Promethee::Promethee(const std::vector<std::vector<float>> &data, const std::vector<float> &weights) : Promethee()
 {
-    this->data = data;
-    this->weights = weights;
+    setData(data);
+    setWeights(weights);
 }
 
 /**
@@ -36,6 +52,71 @@ float Promethee::calculatePreference(float value1, float value2)
     return (value1 > value2) ? 1.0 : 0.0;
 }
 
+/**
+ * @brief Number of criteria that can be compared.
+ *
+ * Only criteria that have both a value column and a weight are taken into account.
+ *
+ * @return int The number of usable criteria.
+ */
+int Promethee::criteriaCount()
+{
+    return std::min(dataset->getNbCriteria(), weights.size());
+}
+
+/**
+ * @brief Choose how the flow contribution of each criterion is computed.
+ *
+ * Criteria with few distinct values (ordinal scores for instance) get the COUNTING plan,
+ * every other criterion keeps the GENERAL pairwise plan. The cardinalities detected by the
+ * parser are used when available, otherwise they are counted here.
+ */
+void Promethee::planCriteria()
+{
+    int m = criteriaCount();
+    std::span<const size_t> criterionCardinalities = dataset->getCriterionCardinalities();
+    bool hasCardinalities = criterionCardinalities.size() >= (size_t)m;
+
+    criterionPlans.assign(m, GENERAL);
+    for (int k = 0; k < m; ++k)
+    {
+        size_t levels;
+        if (hasCardinalities)
+        {
+            levels = criterionCardinalities[k];
+        }
+        else
+        {
+            levels = Parser::countLevels(dataset->expandColumn(k));
+        }
+
+        if (levels <= COUNTING_MAX_LEVELS)
+            criterionPlans[k] = COUNTING;
+    }
+}
+
+/**
+ * @brief Print the plan chosen for each criterion.
+ */
+void Promethee::printCriteriaPlan()
+{
+    std::span<const size_t> criterionCardinalities = dataset->getCriterionCardinalities();
+    int counting = std::count(criterionPlans.begin(), criterionPlans.end(), COUNTING);
+    log() << "Criteria plan: " << counting << " counting, " << criterionPlans.size() - counting << " general\n";
+    for (size_t k = 0; k < criterionPlans.size(); ++k)
+    {
+        log() << "  Criterion " << k + 1 << ": " << (criterionPlans[k] == COUNTING ? "counting" : "general");
+        if (k < criterionCardinalities.size())
+        {
+            if (criterionCardinalities[k] > Parser::MAX_TRACKED_LEVELS)
+                log() << " (> " << Parser::MAX_TRACKED_LEVELS << " levels)";
+            else
+                log() << " (" << criterionCardinalities[k] << " levels)";
+        }
+        log() << "\n";
+    }
+}
+
 /**
  * @brief Calculate the multicriteria preference matrix for all alternatives.
  *
@@ -43,16 +124,76 @@ float Promethee::calculatePreference(float value1, float value2)
  * it calculates the weighted sum of the preferences for each criterion. The results are stored
  * in the `multicriteriaPreferenceMatrix`.
  *
+ * Only criteria with the GENERAL plan are compared here; COUNTING criteria are added directly
+ * to the flows and are only folded into the matrix when it is printed or saved. The rows are
+ * computed by preferenceRows(), instantiated for the number of GENERAL criteria.
+ *
  * @note Diagonal elements (where i == j) are set to -1, indicating no comparison between the same alternative.
  */
 void Promethee::calculatePreferenceMatrix()
 {
-    int n = data.size(); // Number of alternatives
-    int m = data[0].size();    // Number of criterias
+    int n = nbAlternatives(); // Number of alternatives
+    int m = criteriaCount();    // Number of criterias
 
-    for (int i = 0; i < n; ++i)
+    if (criterionPlans.size() != (size_t)m)
+        criterionPlans.assign(m, GENERAL);
+
+    std::vector<int> generalCriteria;
+    for (int k = 0; k < m; ++k)
+    {
+        if (criterionPlans[k] == GENERAL)
+            generalCriteria.push_back(k);
+    }
+
+    resetPartialFlows(n);
+    bool withPartialFlows = !partialFlows.empty();
+
+    // The GENERAL columns as floats, read n times each
+    std::vector<float> generalValues;
+    generalValues.reserve((size_t)n * generalCriteria.size());
+    for (int k : generalCriteria)
+    {
+        std::vector<float> column = dataset->expandColumn(k);
+        generalValues.insert(generalValues.end(), column.begin(), column.end());
+    }
+
+    static constexpr auto kernels = criterionKernelTable([]<int M>()
+                                                         { return &Promethee::preferenceRows<M>; });
+    auto kernel = selectCriterionKernel(kernels, generalCriteria.size());
+
+    // Each row is written by a single task, which also owns the partial flows of its alternative
+    parallelFor(0, n, [&](size_t first, size_t last)
+                { (this->*kernel)(first, last, generalCriteria, generalValues.data(), withPartialFlows); });
+    preferenceMatrixComplete = generalCriteria.size() == (size_t)m;
+}
+
+/**
+ * @brief Preference rows [first, last) of the matrix over the given criteria.
+ *
+ * @tparam M The number of criteria, 0 to read it at run time.
+ * @param criteria The GENERAL criteria.
+ * @param values Their values, criterion by criterion.
+ * @param withPartialFlows Whether the net flow of each criterion is added to the partial flows.
+ */
+template <int M>
+void Promethee::preferenceRows(size_t first, size_t last, std::span<const int> criteria, const float *values, bool withPartialFlows)
+{
+    size_t n = nbAlternatives();
+    const int m = M ? M : criteria.size();
+    CriterionArray<const float *, M> columns(m);
+    CriterionArray<float, M> criterionWeights(m);
+    for (int c = 0; c < m; ++c)
     {
-        for (int j = 0; j < n; ++j)
+        columns[c] = values + c * n;
+        criterionWeights[c] = weights[criteria[c]];
+    }
+
+    CriterionArray<float, M> criterionNet(m);
+    for (size_t i = first; i < last; ++i)
+    {
+        for (int c = 0; c < m; ++c)
+            criterionNet[c] = 0.0f;
+        for (size_t j = 0; j < n; ++j)
         {
             if (i == j)
             {
@@ -60,15 +201,151 @@ void Promethee::calculatePreferenceMatrix()
                 continue;
             }
             float preferenceSum = 0.0f;
-            for (int k = 0; k < m; ++k)
+            for (int c = 0; c < m; ++c)
             {
-                preferenceSum += calculatePreference(data[i][k], data[j][k]) * weights[k];
+                float preference = calculatePreference(columns[c][i], columns[c][j]);
+                preferenceSum += preference * criterionWeights[c];
+                if (withPartialFlows)
+                    criterionNet[c] += (preference - calculatePreference(columns[c][j], columns[c][i])) * criterionWeights[c];
             }
             multicriteriaPreferenceMatrix[i][j] = preferenceSum; // Store the final weighted preference in the matrix
         }
+        if (withPartialFlows)
+        {
+            for (int c = 0; c < m; ++c)
+                addPartialFlow(criteria[c], i, criterionNet[c]);
+        }
+    }
+}
+
+/**
+ * @brief Add the COUNTING criteria to the multicriteria preference matrix.
+ *
+ * Needed only when the full matrix is printed or saved, the flows never depend on it.
+ */
+void Promethee::completePreferenceMatrix()
+{
+    if (preferenceMatrixComplete)
+        return;
+
+    size_t n = nbAlternatives();
+    for (size_t k = 0; k < criterionPlans.size(); ++k)
+    {
+        if (criterionPlans[k] != COUNTING)
+            continue;
+
+        std::vector<float> column = dataset->expandColumn(k);
+        parallelFor(0, n, [&](size_t first, size_t last)
+                    {
+            for (size_t i = first; i < last; ++i)
+            {
+                for (size_t j = 0; j < n; ++j)
+                {
+                    if (i != j)
+                        multicriteriaPreferenceMatrix[i][j] += calculatePreference(column[i], column[j]) * weights[k];
+                }
+            } });
+    }
+    preferenceMatrixComplete = true;
+}
+
+/**
+ * @brief Add the flow contribution of a COUNTING criterion.
+ *
+ * With the usual criterion, alternative i is preferred to every alternative with a lower value
+ * and every alternative with a higher value is preferred to i. Building the histogram of the
+ * criterion levels and its prefix counts therefore gives φ+ and φ− for every alternative
+ * in O(n + levels) instead of comparing all the pairs.
+ *
+ * @param criterium The index of the criterion.
+ * @param positive The φ+ sums of the alternatives.
+ * @param negative The φ− sums of the alternatives.
+ */
+void Promethee::addCountingFlows(int criterium, std::vector<CompensatedSum> &positive, std::vector<CompensatedSum> &negative)
+{
+    int n = nbAlternatives();
+
+    // Sorted distinct values and the level of every alternative
+    std::vector<float> levels;
+    std::vector<int> levelOf(n);
+    for (int i = 0; i < n; ++i)
+    {
+        float criterionValue = value(i, criterium);
+        auto it = std::lower_bound(levels.begin(), levels.end(), criterionValue);
+        if (it == levels.end() || *it != criterionValue)
+            it = levels.insert(it, criterionValue);
+    }
+    std::vector<int> histogram(levels.size(), 0);
+    for (int i = 0; i < n; ++i)
+    {
+        levelOf[i] = std::lower_bound(levels.begin(), levels.end(), value(i, criterium)) - levels.begin();
+        histogram[levelOf[i]]++;
+    }
+
+    // below[l]: alternatives with a strictly lower value than level l
+    std::vector<int> below(levels.size(), 0);
+    for (size_t l = 1; l < levels.size(); ++l)
+        below[l] = below[l - 1] + histogram[l - 1];
+
+    float weight = weights[criterium];
+    for (int i = 0; i < n; ++i)
+    {
+        int l = levelOf[i];
+        int above = n - below[l] - histogram[l];
+        positive[i].add((double)below[l] * weight);
+        negative[i].add((double)above * weight);
+        addPartialFlow(criterium, i, (below[l] - above) * weight);
+    }
+}
+
+/**
+ * @brief Clears the partial flows, one per group of each level of the criteria hierarchy.
+ *
+ * @param n The number of alternatives.
+ */
+void Promethee::resetPartialFlows(size_t n)
+{
+    std::span<const CriterionLevel> hierarchy = dataset->getHierarchy();
+    partialFlows.assign(hierarchy.size(), {});
+    for (size_t level = 0; level < hierarchy.size(); ++level)
+        partialFlows[level].assign(n * hierarchy[level].groups.size(), 0.0f);
+}
+
+/**
+ * @brief Adds the net flow of one criterion to the groups holding it.
+ *
+ * The net flows of the groups of a level sum to φ, so the contribution of a theme or category to
+ * the ranking comes without comparing the alternatives again.
+ *
+ * @param criterium The index of the criterion.
+ * @param alternative The alternative.
+ * @param net φ+ − φ− of the alternative on this criterion, weighted.
+ */
+void Promethee::addPartialFlow(int criterium, int alternative, float net)
+{
+    std::span<const CriterionLevel> hierarchy = dataset->getHierarchy();
+    for (size_t level = 0; level < partialFlows.size(); ++level)
+    {
+        const CriterionLevel &groups = hierarchy[level];
+        if ((size_t)criterium < groups.groupOf.size())
+            partialFlows[level][alternative * groups.groups.size() + groups.groupOf[criterium]] += net;
     }
 }
 
+/**
+ * @brief File name of the partial flows of a hierarchy level, without extension.
+ *
+ * @param level The level, 0 for the coarsest.
+ * @return e.g. "partialFlows_Thèmes".
+ */
+std::string Promethee::partialFlowsName(size_t level)
+{
+    std::string label = dataset->getHierarchy()[level].label;
+    std::replace_if(label.begin(), label.end(), [](char c)
+                    { return c == '/' || c == '\\' || c == ' '; }, '_');
+    return "partialFlows_" + label;
+}
+
 /**
  * @brief Print the multicriteria preference matrix.
  *
@@ -78,17 +355,18 @@ void Promethee::calculatePreferenceMatrix()
  */
 void Promethee::printPreferenceMatrix()
 {
-    std::cout << "Preference Matrix:\n";
+    completePreferenceMatrix();
+    log() << "Preference Matrix:\n";
     for (int i = 0; i < multicriteriaPreferenceMatrix.size(); ++i)
     {
         for (int j = 0; j < multicriteriaPreferenceMatrix[i].size(); ++j)
         {
             if (multicriteriaPreferenceMatrix[i][j] == 0)
-                std::cout << std::setw(4) << "-1" << "\t"; // Diagonal element
+                log() << std::setw(4) << "-1" << "\t"; // Diagonal element
             else
-                std::cout << std::setw(4) << multicriteriaPreferenceMatrix[i][j] << "\t"; // Other elements
+                log() << std::setw(4) << multicriteriaPreferenceMatrix[i][j] << "\t"; // Other elements
         }
-        std::cout << std::endl;
+        log() << std::endl;
     }
 }
 
@@ -97,28 +375,59 @@ void Promethee::printPreferenceMatrix()
  *
  * Positive flow (φ+) represents how much an alternative outranks other alternatives.
  * Negative flow (φ−) represents how much an alternative is outranked by others.
+ * The GENERAL criteria are read from the preference matrix, the COUNTING criteria are added
+ * from their histograms. Every sum is a CompensatedSum in a fixed order, so the flows do not
+ * depend on the number of threads.
  */
 void Promethee::calculateFlows()
 {
     int n = multicriteriaPreferenceMatrix.size(); // Number of alternatives
+    std::vector<CompensatedSum> positive(n), negative(n);
 
-    // Resize the positive and negative flow vectors to store values for each alternative
-    positiveFlow.resize(n, 0.0);
-    negativeFlow.resize(n, 0.0);
-    flows.resize(n, 0.0);
-
-    // Calculate the positive and negative flows
-    for (int i = 0; i < n; ++i)
-    {
-        for (int j = 0; j < n; ++j)
+    // Calculate the positive and negative flows, each alternative in a single task
+    parallelFor(0, n, [&](size_t first, size_t last)
+                {
+        for (int i = first; i < (int)last; ++i)
         {
-            if (i != j)
+            for (int block = 0; block < n; block += REDUCTION_BLOCK)
             {
-                positiveFlow[i] += multicriteriaPreferenceMatrix[i][j]; // Sum of how much i outranks others
-                negativeFlow[i] += multicriteriaPreferenceMatrix[j][i]; // Sum of how much i is outranked by others
+                double outranks = 0, outranked = 0;
+                for (int j = block; j < std::min<int>(n, block + REDUCTION_BLOCK); ++j)
+                {
+                    if (i != j)
+                    {
+                        outranks += multicriteriaPreferenceMatrix[i][j];   // Sum of how much i outranks others
+                        outranked += multicriteriaPreferenceMatrix[j][i]; // Sum of how much i is outranked by others
+                    }
+                }
+                positive[i].add(outranks);
+                negative[i].add(outranked);
             }
-        }
-        flows[i] = positiveFlow[i] - negativeFlow[i];
+        } });
+
+    for (size_t k = 0; k < criterionPlans.size(); ++k)
+    {
+        if (criterionPlans[k] == COUNTING)
+            addCountingFlows(k, positive, negative);
+    }
+
+    storeFlows(positive, negative);
+}
+
+/**
+ * @brief Rounds the accumulated φ+ and φ− to the flow vectors, φ being computed before rounding.
+ */
+void Promethee::storeFlows(const std::vector<CompensatedSum> &positive, const std::vector<CompensatedSum> &negative)
+{
+    size_t n = positive.size();
+    positiveFlow.resize(n);
+    negativeFlow.resize(n);
+    flows.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        positiveFlow[i] = positive[i].value();
+        negativeFlow[i] = negative[i].value();
+        flows[i] = positive[i].value() - negative[i].value();
     }
 }
 
@@ -138,34 +447,461 @@ void Promethee::calculateBestCandidates()
 
 std::vector<int> Promethee::calculatePosition(std::vector<float> valuesVec, OptimizationType order) 
 {
-    std::vector<int> returnVec(data.size(), -1);
+    std::vector<int> returnVec(valuesVec.size(), -1);
     
-    for (int currentAlt = 0; currentAlt < data.size(); currentAlt++) 
+    parallelFor(0, valuesVec.size(), [&](size_t first, size_t last)
+                {
+        for (int currentAlt = first; currentAlt < (int)last; currentAlt++) 
+        {
+            int position = 1;
+
+            float currentAltValue = valuesVec[currentAlt]; 
+            for (int otherAlt = 0; otherAlt < (int)valuesVec.size(); otherAlt++) 
+            {
+                // no need to check if the other alternative is better if they are the same alternative
+                if (currentAlt == otherAlt)
+                    continue;
+
+                if (order == MAX) 
+                {
+                    if (currentAltValue < valuesVec[otherAlt])
+                        position++;
+                }
+                else if (order == MIN) 
+                {
+                    if (currentAltValue > valuesVec[otherAlt])
+                        position++;
+                }
+            }
+            returnVec[currentAlt] = position;
+        } });
+
+    return returnVec;
+}
+
+/**
+ * @brief Weighted preference of one alternative over another on all the criteria.
+ *
+ * @param alternative1 The index of the first alternative.
+ * @param alternative2 The index of the second alternative.
+ * @return float The same value as the preference matrix cell (alternative1, alternative2).
+ */
+float Promethee::pairPreference(int alternative1, int alternative2)
+{
+    int m = criteriaCount();
+    float preferenceSum = 0.0f;
+    for (int k = 0; k < m; ++k)
     {
-        int position = 1;
+        preferenceSum += calculatePreference(value(alternative1, k), value(alternative2, k)) * weights[k];
+    }
+    return preferenceSum;
+}
+
+/**
+ * @brief Estimate the flows from a stratified sample of opponents.
+ *
+ * The opponents are split into APPROXIMATION_STRATA blocks and every round draws the same number
+ * of opponents from each block for each alternative, doubling the draws from one round to the next.
+ * φ+ and φ− are the stratified means of the sampled preferences scaled to the n - 1 opponents.
+ * Since a preference lies in [0, sum of the weights], Hoeffding's inequality gives for each flow a
+ * confidence interval that holds for all the alternatives at once with probability 1 - APPROXIMATION_DELTA.
+ * The stopping rule only looks at the numbers of draws, never at the sampled preferences, so
+ * stopping early does not weaken the intervals.
+ *
+ * Sampling stops when the deadline is reached, when every φ interval is narrower than epsilon
+ * (in units of n - 1 opponents), or when sampling would cost as much as the exact flows. In the
+ * last case the exact flows replace the estimates one alternative at a time until the deadline.
+ * The first round is always completed.
+ */
+void Promethee::runApproximate()
+{
+    int n = nbAlternatives();
+    int m = criteriaCount();
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&start]()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    positiveFlow.assign(n, 0.0);
+    negativeFlow.assign(n, 0.0);
+    flows.assign(n, 0.0);
+    positiveMargin.assign(n, 0.0);
+    negativeMargin.assign(n, 0.0);
+    flowMargin.assign(n, 0.0);
+    if (n < 2)
+        return;
+
+    float range = 0.0f;
+    for (int k = 0; k < m; ++k)
+        range += weights[k];
+
+    int strataCount = std::min(APPROXIMATION_STRATA, n - 1);
+    std::vector<int> strataStart(strataCount + 1);
+    int largestStratum = 0;
+    for (int s = 0; s <= strataCount; ++s)
+    {
+        strataStart[s] = (long)s * n / strataCount;
+        if (s > 0)
+            largestStratum = std::max(largestStratum, strataStart[s] - strataStart[s - 1]);
+    }
+
+    std::mt19937_64 generator(seed);
+    std::vector<double> positiveSum(n, 0.0); // Σ over draws of (stratum share) × preference
+    std::vector<double> negativeSum(n, 0.0);
+    std::vector<long> draws(n, 0);            // Draws per stratum so far
+    // Union bound over the 2n two-sided intervals, φ+ and φ− of every alternative
+    double logTerm = std::log(4.0 * n / APPROXIMATION_DELTA);
+    bool exact = false;
+    bool deadlineReached = false;
+    long roundDraws = 1;
+    int rounds = 0;
 
-        float currentAltValue = valuesVec[currentAlt]; 
-        for (int otherAlt = 0; otherAlt < data.size(); otherAlt++) 
+    while (!deadlineReached)
+    {
+        if (draws[0] + roundDraws >= largestStratum)
         {
-            // no need to check if the other alternative is better if they are the same alternative
-            if (currentAlt == otherAlt)
-                continue;
+            exact = true;
+            break;
+        }
 
-            if (order == MAX) 
+        for (int i = 0; i < n; ++i)
+        {
+            for (int s = 0; s < strataCount; ++s)
             {
-                if (currentAltValue < valuesVec[otherAlt])
-                    position++;
+                int first = strataStart[s];
+                int size = strataStart[s + 1] - first;
+                bool containsSelf = i >= first && i < first + size;
+                int opponents = size - (containsSelf ? 1 : 0);
+                if (opponents == 0)
+                    continue;
+
+                double share = (double)opponents / (n - 1);
+                std::uniform_int_distribution<int> pick(0, opponents - 1);
+                for (long d = 0; d < roundDraws; ++d)
+                {
+                    int j = first + pick(generator);
+                    if (containsSelf && j >= i)
+                        j++;
+                    positiveSum[i] += share * pairPreference(i, j);
+                    negativeSum[i] += share * pairPreference(j, i);
+                }
             }
-            else if (order == MIN) 
+            draws[i] += roundDraws;
+
+            // The first round gives every alternative an estimate, later ones may stop anywhere
+            if (rounds > 0 && elapsedMs() >= deadlineMs)
             {
-                if (currentAltValue > valuesVec[otherAlt])
-                    position++;
+                deadlineReached = true;
+                break;
             }
         }
-        returnVec[currentAlt] = position;
+        rounds++;
+        roundDraws *= 2;
+
+        if (elapsedMs() >= deadlineMs)
+            deadlineReached = true;
+
+        if (epsilon > 0)
+        {
+            // Narrowest sample decides, the share term is at most 1
+            long fewestDraws = *std::min_element(draws.begin(), draws.end());
+            double widest = 2 * range * std::sqrt(logTerm / (2.0 * fewestDraws));
+            if (widest <= epsilon)
+                break;
+        }
     }
 
-    return returnVec;
+    for (int i = 0; i < n && draws[i] > 0; ++i)
+    {
+        // Σ (N_s / N)² over the strata, the Hoeffding factor of a stratified mean
+        double shareSquares = 0.0;
+        for (int s = 0; s < strataCount; ++s)
+        {
+            int size = strataStart[s + 1] - strataStart[s];
+            if (i >= strataStart[s] && i < strataStart[s + 1])
+                size--;
+            double share = (double)size / (n - 1);
+            shareSquares += share * share;
+        }
+        double halfWidth = (n - 1) * range * std::sqrt(shareSquares * logTerm / (2.0 * draws[i]));
+
+        positiveFlow[i] = (n - 1) * positiveSum[i] / draws[i];
+        negativeFlow[i] = (n - 1) * negativeSum[i] / draws[i];
+        flows[i] = positiveFlow[i] - negativeFlow[i];
+        positiveMargin[i] = halfWidth;
+        negativeMargin[i] = halfWidth;
+        flowMargin[i] = 2 * halfWidth;
+    }
+
+    // Exact flows replace the estimates alternative by alternative while time remains
+    int exactAlternatives = 0;
+    if (exact)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            if (rounds > 0 && elapsedMs() >= deadlineMs)
+                break;
+
+            positiveFlow[i] = 0.0;
+            negativeFlow[i] = 0.0;
+            for (int j = 0; j < n; ++j)
+            {
+                if (i == j)
+                    continue;
+                positiveFlow[i] += pairPreference(i, j);
+                negativeFlow[i] += pairPreference(j, i);
+            }
+            flows[i] = positiveFlow[i] - negativeFlow[i];
+            positiveMargin[i] = 0.0;
+            negativeMargin[i] = 0.0;
+            flowMargin[i] = 0.0;
+            exactAlternatives++;
+        }
+    }
+
+    log() << "Approximation: " << rounds << " sampling rounds, " << exactAlternatives << " exact flows"
+              << " in " << std::fixed << std::setprecision(1) << elapsedMs() << " ms"
+              << std::defaultfloat << std::setprecision(6) << "\n";
+}
+
+/**
+ * @brief Count, for each alternative, the alternatives with a lower and a higher value.
+ *
+ * @param values The values of one criterion for all the alternatives.
+ * @param below Receives the number of alternatives with a strictly lower value.
+ * @param above Receives the number of alternatives with a strictly higher value.
+ */
+void Promethee::countOutranked(std::span<const float> values, std::vector<int> &below, std::vector<int> &above)
+{
+    std::vector<float> sorted(values.begin(), values.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    below.resize(values.size());
+    above.resize(values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        below[i] = std::lower_bound(sorted.begin(), sorted.end(), values[i]) - sorted.begin();
+        above[i] = sorted.end() - std::upper_bound(sorted.begin(), sorted.end(), values[i]);
+    }
+}
+
+/**
+ * @brief Compute the flows while the data file is being read.
+ *
+ * Each line of the data file holds one criterion for all the alternatives, which is a complete
+ * unicriterion problem: its weighted contribution to φ+ and φ− only needs the number of
+ * alternatives below and above each value. A reader thread parses the lines into a bounded queue
+ * and one consumer task per scheduler thread turns each line into its contribution as soon as it
+ * is available, so the decision matrix is never resident and parsing overlaps with computing.
+ * The reader is a plain thread rather than a task: it blocks on the file, and the consumers can
+ * only wait on the queue because the reader always makes progress.
+ *
+ * The contributions are committed in criterion order whatever order the consumers finish in, so
+ * the flows are the same for any number of threads. A consumer whose criterion is too far ahead of
+ * the next one to commit waits for it; that criterion was popped before, by a consumer that never
+ * waits, so the window of pending contributions always drains.
+ */
+void Promethee::runStreaming()
+{
+    struct CriterionLine
+    {
+        int criterium;
+        std::vector<float> values;
+    };
+
+    // Counts of a criterion waiting for the previous ones to be committed
+    struct Contribution
+    {
+        bool used;
+        size_t alternatives;
+        float weight;
+        std::vector<int> below, above;
+    };
+
+    int consumers = scheduler ? scheduler->getThreadCount() : 1;
+    BlockingQueue<CriterionLine> queue(2 * consumers);
+    std::mutex flowsMutex;
+    std::condition_variable committed;
+    std::map<int, Contribution> pending;
+    int nextCommit = 0;
+    int criteriaRead = 0;
+    bool invalidLine = false;
+
+    std::vector<CompensatedSum> positive, negative;
+    partialFlows.clear();
+
+    // Called with flowsMutex held
+    auto commit = [&](int criterium, const Contribution &contribution)
+    {
+        if (!contribution.used)
+            return;
+        if (positive.empty())
+        {
+            positive.resize(contribution.alternatives);
+            negative.resize(contribution.alternatives);
+            resetPartialFlows(contribution.alternatives);
+        }
+        if (contribution.alternatives != positive.size())
+        {
+            invalidLine = true;
+            return;
+        }
+        for (size_t i = 0; i < contribution.alternatives; ++i)
+        {
+            positive[i].add((double)contribution.below[i] * contribution.weight);
+            negative[i].add((double)contribution.above[i] * contribution.weight);
+            addPartialFlow(criterium, i, (contribution.below[i] - contribution.above[i]) * contribution.weight);
+        }
+    };
+
+    std::thread reader([&]
+                       {
+        Parser parser;
+        std::ifstream file(streamingSource);
+        if (!file.is_open())
+        {
+            std::cerr << "Error: " << streamingSource << std::endl;
+        }
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            queue.push({criteriaRead, parser.split(line)});
+            criteriaRead++;
+        }
+        queue.close(); });
+
+    auto consume = [&]
+    {
+        while (std::optional<CriterionLine> line = queue.pop())
+        {
+            Contribution contribution{(size_t)line->criterium < weights.size(), line->values.size(), 0, {}, {}};
+            if (contribution.used)
+            {
+                countOutranked(line->values, contribution.below, contribution.above);
+                contribution.weight = weights[line->criterium];
+            }
+
+            std::unique_lock<std::mutex> lock(flowsMutex);
+            committed.wait(lock, [&]
+                           { return line->criterium < nextCommit + 2 * consumers; });
+            pending.emplace(line->criterium, std::move(contribution));
+            bool advanced = false;
+            for (auto next = pending.begin(); next != pending.end() && next->first == nextCommit; next = pending.erase(next))
+            {
+                commit(next->first, next->second);
+                nextCommit++;
+                advanced = true;
+            }
+            if (advanced)
+                committed.notify_all();
+        }
+    };
+
+    if (scheduler)
+    {
+        TaskScheduler::TaskGroup group(*scheduler);
+        for (int c = 0; c < consumers; ++c)
+            group.run(consume);
+        group.wait();
+    }
+    else
+    {
+        consume();
+    }
+    reader.join();
+
+    if (invalidLine)
+        std::cerr << "Error: the lines of " << streamingSource << " do not all have the same number of alternatives" << std::endl;
+
+    storeFlows(positive, negative);
+
+    log() << "Streamed " << criteriaRead << " criteria over " << flows.size() << " alternatives with "
+              << consumers << " workers\n";
+}
+
+/**
+ * @brief Compute the flows from precomputed outranking counts.
+ *
+ * The counts only depend on the values, so they can be kept across runs that change the
+ * weights: the flows are then a weighted sum over the criteria, in O(n·m).
+ */
+void Promethee::flowsFromCounts()
+{
+    int n = nbAlternatives();
+    size_t m = std::min(outrankingCounts->size(), weights.size());
+
+    std::vector<CompensatedSum> positive(n), negative(n);
+    resetPartialFlows(n);
+    for (size_t k = 0; k < m; ++k)
+    {
+        const CriterionCounts &counts = (*outrankingCounts)[k];
+        float weight = weights[k];
+        for (int i = 0; i < n; ++i)
+        {
+            positive[i].add((double)counts.below[i] * weight);
+            negative[i].add((double)counts.above[i] * weight);
+            addPartialFlow(k, i, (counts.below[i] - counts.above[i]) * weight);
+        }
+    }
+    storeFlows(positive, negative);
+}
+
+/**
+ * @brief Rank the alternatives by estimated φ and find the settled positions.
+ *
+ * A position is settled when the confidence interval of the alternative holding it lies strictly
+ * below every interval ranked above and strictly above every interval ranked below.
+ */
+void Promethee::settleRanking()
+{
+    int n = flows.size();
+    rankedAlternatives.resize(n);
+    std::iota(rankedAlternatives.begin(), rankedAlternatives.end(), 0);
+    std::stable_sort(rankedAlternatives.begin(), rankedAlternatives.end(), [this](int a, int b)
+                     { return flows[a] > flows[b]; });
+
+    std::vector<float> lowestAbove(n, INFINITY);
+    std::vector<float> highestBelow(n, -INFINITY);
+    for (int p = 1; p < n; ++p)
+    {
+        int previous = rankedAlternatives[p - 1];
+        lowestAbove[p] = std::min(lowestAbove[p - 1], flows[previous] - flowMargin[previous]);
+    }
+    for (int p = n - 2; p >= 0; --p)
+    {
+        int next = rankedAlternatives[p + 1];
+        highestBelow[p] = std::max(highestBelow[p + 1], flows[next] + flowMargin[next]);
+    }
+
+    settledPositions.assign(n, false);
+    for (int p = 0; p < n; ++p)
+    {
+        int alternative = rankedAlternatives[p];
+        settledPositions[p] = lowestAbove[p] > flows[alternative] + flowMargin[alternative] &&
+                              highestBelow[p] < flows[alternative] - flowMargin[alternative];
+    }
+}
+
+/**
+ * @brief Print the top-K of the approximate ranking with its confidence intervals.
+ */
+void Promethee::printApproximation()
+{
+    int shown = std::min<int>(topK, rankedAlternatives.size());
+    int settled = 0;
+    while (settled < shown && settledPositions[settled])
+        settled++;
+
+    log() << "Top-" << shown << " (" << (1 - APPROXIMATION_DELTA) * 100 << "% simultaneous confidence):\n";
+    for (int p = 0; p < shown; ++p)
+    {
+        int alternative = rankedAlternatives[p];
+        log() << "  #" << p + 1 << " Alternative " << alternative + 1 << ": φ = " << flows[alternative]
+                  << " ± " << flowMargin[alternative] << (settledPositions[p] ? " (settled)" : "") << "\n";
+    }
+    log() << "Positions 1 to " << settled << " of the top-" << shown << " are settled.\n";
 }
 
 /**
@@ -176,50 +912,53 @@ std::vector<int> Promethee::calculatePosition(std::vector<float> valuesVec, Opti
  */
 void Promethee::printFlows()
 {
-    std::cout << "Positive Flow (φ+):\n";
+    log() << "Positive Flow (φ+):\n";
     for (int i = 0; i < positiveFlow.size(); ++i)
     {
-        // std::cout << "Alternative " << i + 1 << ": " << std::setw(6) << positiveFlow[i] << "\n";
-        std::cout << "Alternative " << i + 1 << ": " <<  positiveFlow[i] << "\n";
+        // log() << "Alternative " << i + 1 << ": " << std::setw(6) << positiveFlow[i] << "\n";
+        log() << "Alternative " << i + 1 << ": " <<  positiveFlow[i] << "\n";
     }
 
-    std::cout << "\nNegative Flow (φ−):\n";
+    log() << "\nNegative Flow (φ−):\n";
     for (int i = 0; i < negativeFlow.size(); ++i)
     {
-        // std::cout << "Alternative " << i + 1 << ": " << std::setw(6) << negativeFlow[i] << "\n";
-        std::cout << "Alternative " << i + 1 << ": " <<  negativeFlow[i] << "\n";
+        // log() << "Alternative " << i + 1 << ": " << std::setw(6) << negativeFlow[i] << "\n";
+        log() << "Alternative " << i + 1 << ": " <<  negativeFlow[i] << "\n";
     }
 
-    std::cout << "\nFlows (φ):\n";
+    log() << "\nFlows (φ):\n";
     for (int i = 0; i < flows.size(); ++i)
     {
-        // std::cout << "Alternative " << i + 1 << ": " << std::setw(6) << flows[i] << "\n";
-        std::cout << "Alternative " << i + 1 << ": " <<  flows[i] << "\n";
+        // log() << "Alternative " << i + 1 << ": " << std::setw(6) << flows[i] << "\n";
+        log() << "Alternative " << i + 1 << ": " <<  flows[i] << "\n";
     }
 }
 
 void Promethee::printLatexOutput()
 {
     // TODO: add the preference matrix to latex output
-    std::cout << "\\begin{table}[h] \n";
-    std::cout << "\\centering \n";
-    std::cout << "\\begin{tabular}{|c|c|c|c|} \n";
-    std::cout << "\\hline \n";
-    std::cout << "\\textbf{Alternative} & \\textbf{Positive Flow (\\varphi+)} & \\textbf{Negative Flow (\\varphi−)} & \\textbf{Flows (\\varphi)} \\\\ \n";
-    std::cout << "\\hline \n";
+    log() << "\\begin{table}[h] \n";
+    log() << "\\centering \n";
+    log() << "\\begin{tabular}{|c|c|c|c|} \n";
+    log() << "\\hline \n";
+    log() << "\\textbf{Alternative} & \\textbf{Positive Flow (\\varphi+)} & \\textbf{Negative Flow (\\varphi−)} & \\textbf{Flows (\\varphi)} \\\\ \n";
+    log() << "\\hline \n";
     for (int i = 0; i < flows.size(); ++i)
     {
-        std::cout << "Alternative " << i + 1 << ": & " << positiveFlow[i] << " & " << negativeFlow[i] << " & " << flows[i] << " \\\\ \n";
+        log() << "Alternative " << i + 1 << ": & " << positiveFlow[i] << " & " << negativeFlow[i] << " & " << flows[i] << " \\\\ \n";
     }
-    std::cout << "\\hline \n";
-    std::cout << "\\end{tabular} \n";
-    std::cout << "\\caption{Promethee Flow Data} \n";
-    std::cout << "\\label{tab:promethee_flows} \n";
-    std::cout << "\\end{table} \n";
+    log() << "\\hline \n";
+    log() << "\\end{tabular} \n";
+    log() << "\\caption{Promethee Flow Data} \n";
+    log() << "\\label{tab:promethee_flows} \n";
+    log() << "\\end{table} \n";
 }
 
 int Promethee::save(std::string dirPath)
 {
+    if (!approximate)
+        completePreferenceMatrix();
+
     std::filesystem::path folderPath = std::filesystem::path(dirPath) / "Promethee";
 
     if (!std::filesystem::exists(folderPath)) {
@@ -229,30 +968,68 @@ int Promethee::save(std::string dirPath)
         }
     }
 
+    if (outputFormat != CSV) {
+        return saveArrays(folderPath);
+    }
 
-    std::filesystem::path filePath = folderPath / "multicriteriaPreferenceMatrix.csv";
-    std::ofstream outputFileMatrix(filePath);
+    std::filesystem::path filePath;
+    if (!streamingSource.empty() || outrankingCounts) {
+        // Only the flows are computed by the streaming pipeline and from the counts
+    } else if (approximate) {
+        // The preference matrix is never computed, the confidence intervals are saved instead
+        filePath = folderPath / "flowsConfidence.csv";
+        CsvWriter outputFileConfidence(filePath);
 
-    if (!outputFileMatrix) {
-        std::cerr << "Error creating file for writing" << std::endl;
-        return -1;
-    }
+        if (!outputFileConfidence) {
+            std::cerr << "Error creating file for writing" << std::endl;
+            return -1;
+        }
+
+        std::vector<int> positionOf(flows.size());
+        for (size_t p = 0; p < rankedAlternatives.size(); ++p) {
+            positionOf[rankedAlternatives[p]] = p;
+        }
+
+        outputFileConfidence << "Flow margin,Positive Flow margin,Negative Flow margin,Settled\n";
+        for (size_t i = 0; i < flows.size(); ++i) {
+            outputFileConfidence << flowMargin[i] << ','
+                                 << positiveMargin[i] << ','
+                                 << negativeMargin[i] << ','
+                                 << (bool)settledPositions[positionOf[i]] << '\n';
+        }
+
+        if (!outputFileConfidence.close()) {
+            return -1;
+        }
+    } else {
+        filePath = folderPath / "multicriteriaPreferenceMatrix.csv";
+        CsvWriter outputFileMatrix(filePath);
+
+        if (!outputFileMatrix) {
+            std::cerr << "Error creating file for writing" << std::endl;
+            return -1;
+        }
 
-    for (const auto& row : this->multicriteriaPreferenceMatrix) {
-        for (size_t i = 0; i < row.size(); ++i) {
-            outputFileMatrix << row[i];
-            if (i < row.size() - 1) {
-                outputFileMatrix << ";";
+        // n² values: the rows are formatted in parallel
+        outputFileMatrix.writeRows(multicriteriaPreferenceMatrix.size(), [&](size_t r, std::string &out) {
+            const std::vector<float> &row = multicriteriaPreferenceMatrix[r];
+            for (size_t i = 0; i < row.size(); ++i) {
+                CsvWriter::append(out, row[i]);
+                if (i < row.size() - 1) {
+                    out += ';';
+                }
             }
+            out += '\n';
+        }, scheduler);
+
+        if (!outputFileMatrix.close()) {
+            return -1;
         }
-        outputFileMatrix << "\n";
     }
 
-    outputFileMatrix.close();
-
 
     filePath = folderPath / "flowsData.csv";
-    std::ofstream outputFileFlow(filePath);
+    CsvWriter outputFileFlow(filePath);
 
     if (!outputFileFlow) {
         std::cerr << "Error creating file for writing" << std::endl;
@@ -261,59 +1038,249 @@ int Promethee::save(std::string dirPath)
     outputFileFlow << "Flow,Positive Flow,Negative Flow\n";
 
     for (size_t i = 0; i < flows.size(); ++i) {
-        outputFileFlow << flows[i] << "," 
-                   << positiveFlow[i] << "," 
-                   << negativeFlow[i] << "\n";
+        outputFileFlow << flows[i] << ','
+                   << positiveFlow[i] << ','
+                   << negativeFlow[i] << '\n';
     }
 
-    outputFileFlow.close();
+    if (!outputFileFlow.close()) {
+        return -1;
+    }
 
     filePath = folderPath / "bestAlternatives.csv";
-    std::ofstream outputFileBestAlternatives(filePath);
+    CsvWriter outputFileBestAlternatives(filePath);
 
     if (!outputFileBestAlternatives) {
         std::cerr << "Error creating file for writing" << std::endl;
         return -1;
     }
 
-    outputFileBestAlternatives << "Flow,Positive Flow,Negative Flow" << "\n";
+    outputFileBestAlternatives << "Flow,Positive Flow,Negative Flow\n";
     for (size_t i = 0; i < flows.size(); ++i) {
-        outputFileBestAlternatives << bestAlternativesOverall[i] << ","
-                                   << bestAlternativesPositive[i] << "," 
-                                   << bestAlternativesNegative[i] << "\n";
+        outputFileBestAlternatives << bestAlternativesOverall[i] << ','
+                                   << bestAlternativesPositive[i] << ','
+                                   << bestAlternativesNegative[i] << '\n';
     }
 
-    outputFileBestAlternatives.close();
+    if (!outputFileBestAlternatives.close()) {
+        return -1;
+    }
+
+    // One column per group, e.g. per theme, the group names quoted as they may hold commas
+    std::span<const CriterionLevel> hierarchy = dataset->getHierarchy();
+    for (size_t level = 0; level < partialFlows.size(); ++level) {
+        filePath = folderPath / (partialFlowsName(level) + ".csv");
+        CsvWriter outputFilePartial(filePath);
+
+        if (!outputFilePartial) {
+            std::cerr << "Error creating file for writing" << std::endl;
+            return -1;
+        }
+
+        size_t groups = hierarchy[level].groups.size();
+        for (size_t g = 0; g < groups; ++g) {
+            std::string group = hierarchy[level].groups[g];
+            for (size_t quote = group.find('"'); quote != std::string::npos; quote = group.find('"', quote + 2)) {
+                group.insert(quote, 1, '"');
+            }
+            outputFilePartial << (g ? ",\"" : "\"") << group << '"';
+        }
+        outputFilePartial << '\n';
+        for (size_t i = 0; i < flows.size(); ++i) {
+            for (size_t g = 0; g < groups; ++g) {
+                if (g) {
+                    outputFilePartial << ',';
+                }
+                outputFilePartial << partialFlows[level][i * groups + g];
+            }
+            outputFilePartial << '\n';
+        }
+
+        if (!outputFilePartial.close()) {
+            return -1;
+        }
+    }
 
     return 1;
 }
 
-void Promethee::run()
+/**
+ * @brief Saves the results as binary arrays, see ArrayExport.
+ *
+ *  Same contents as the CSV files: the preference matrix (or the confidence intervals of the
+ *  approximation), the three flows and the three rankings.
+ *
+ * @param folderPath The Promethee output directory.
+ * @return 1 on success, -1 if a file could not be written.
+ */
+int Promethee::saveArrays(const std::filesystem::path &folderPath)
+{
+    ArrayExport arrays(folderPath, outputFormat, scheduler);
+    bool written = true;
+
+    if (!streamingSource.empty() || outrankingCounts) {
+        // Only the flows are computed by the streaming pipeline and from the counts
+    } else if (approximate) {
+        std::vector<bool> settled(flows.size());
+        for (size_t p = 0; p < rankedAlternatives.size(); ++p) {
+            settled[rankedAlternatives[p]] = settledPositions[p];
+        }
+        written = arrays.add("flowMargin", flowMargin) && arrays.add("positiveFlowMargin", positiveMargin) &&
+                  arrays.add("negativeFlowMargin", negativeMargin) && arrays.add("settled", settled);
+    } else {
+        size_t n = multicriteriaPreferenceMatrix.size();
+        written = arrays.addRows("multicriteriaPreferenceMatrix", "<f4", {n, n}, n * sizeof(float), [&](size_t row, uint8_t *destination) {
+            std::memcpy(destination, multicriteriaPreferenceMatrix[row].data(), n * sizeof(float));
+        });
+    }
+
+    written = written && arrays.add("flow", flows) && arrays.add("positiveFlow", positiveFlow) &&
+              arrays.add("negativeFlow", negativeFlow) && arrays.add("bestAlternativesOverall", bestAlternativesOverall) &&
+              arrays.add("bestAlternativesPositive", bestAlternativesPositive) &&
+              arrays.add("bestAlternativesNegative", bestAlternativesNegative);
+
+    std::span<const CriterionLevel> hierarchy = dataset->getHierarchy();
+    for (size_t level = 0; written && level < partialFlows.size(); ++level) {
+        size_t groups = hierarchy[level].groups.size();
+        Json details = Json::object();
+        details["labels"] = Json::array(hierarchy[level].groups);
+        details["description"] = "net flow of each group of " + hierarchy[level].label + ", one row per alternative";
+        written = arrays.addRows(partialFlowsName(level), "<f4", {flows.size(), groups}, groups * sizeof(float), [&](size_t row, uint8_t *destination) {
+            std::memcpy(destination, partialFlows[level].data() + row * groups, groups * sizeof(float));
+        }, details);
+    }
+    written = written && arrays.writeManifest(name);
+    return written ? 1 : -1;
+}
+
+/**
+ * @brief Describes the best alternative of the last run.
+ *
+ * @return The alternative with the highest φ and its flow.
+ */
+std::string Promethee::summary()
+{
+    if (flows.empty())
+        return "no flows";
+    size_t best = std::max_element(flows.begin(), flows.end()) - flows.begin();
+    std::ostringstream line;
+    line << "best alternative " << best + 1 << " (φ = " << flows[best] << ")";
+    return line.str();
+}
+
+/**
+ * @brief Options that change the saved flows.
+ *
+ * @return Nothing for the approximation, which depends on the time budget, and for the streaming
+ * and precomputed counts modes, whose data is not part of the dataset.
+ */
+std::optional<std::string> Promethee::cacheConfiguration() const
+{
+    if (approximate || !streamingSource.empty() || outrankingCounts)
+        return std::nullopt;
+    return "";
+}
+
+bool Promethee::run(TaskScheduler &taskScheduler)
 {
-    std::cout << GREEN << "========== Starting Promethee Algorithm ==========" << RESET << "\n";
+    scheduler = &taskScheduler;
+    log() << GREEN << "========== Starting Promethee Algorithm ==========" << RESET << "\n";
+
+    if (outrankingCounts)
+    {
+        // Step 1: Weight the counts
+        log() << BLUE << "[Step 1/2]" << RESET << " Computing flows from the outranking counts..." << std::endl;
+        ProfileScope stage("Promethee/flows");
+        flowsFromCounts();
+        log() << GREEN << "✔ Flows computed successfully." << RESET << "\n";
+
+        // Step 2: Compute best alternatives
+        log() << BLUE << "[Step 2/2]" << RESET << " Computing best alternatives..." << std::endl;
+        stage.next("Promethee/ranking");
+        calculateBestCandidates();
+        log() << GREEN << "✔ Best alternatives computed successfully." << RESET << "\n";
+
+        log() << GREEN << "========== Promethee Algorithm Completed ==========" << RESET << "\n";
+        return true;
+    }
+
+    if (!streamingSource.empty())
+    {
+        // Step 1: Stream the criteria
+        log() << BLUE << "[Step 1/2]" << RESET << " Streaming criteria and computing flows..." << std::endl;
+        ProfileScope stage("Promethee/streaming");
+        runStreaming();
+        log() << GREEN << "✔ Flows computed successfully." << RESET << "\n";
+
+        // Step 2: Compute best alternatives
+        log() << BLUE << "[Step 2/2]" << RESET << " Computing best alternatives..." << std::endl;
+        stage.next("Promethee/ranking");
+        calculateBestCandidates();
+        log() << GREEN << "✔ Best alternatives computed successfully." << RESET << "\n";
+
+        log() << GREEN << "========== Promethee Algorithm Completed ==========" << RESET << "\n";
+        return true;
+    }
+
+    if (approximate)
+    {
+        // Step 1: Sample opponents
+        log() << BLUE << "[Step 1/3]" << RESET << " Estimating flows from sampled opponents..." << std::endl;
+        ProfileScope stage("Promethee/sampling");
+        partialFlows.clear(); // Not estimated from the samples
+        runApproximate();
+        log() << GREEN << "✔ Flows estimated successfully." << RESET << "\n";
+
+        // Step 2: Compute best alternatives
+        log() << BLUE << "[Step 2/3]" << RESET << " Computing best alternatives..." << std::endl;
+        stage.next("Promethee/ranking");
+        bestAlternativesPositive.resize(nbAlternatives(), -1);
+        bestAlternativesNegative.resize(nbAlternatives(), -1);
+        bestAlternativesOverall.resize(nbAlternatives(), -1);
+        calculateBestCandidates();
+        log() << GREEN << "✔ Best alternatives computed successfully." << RESET << "\n";
+
+        // Step 3: Settle the top positions
+        log() << BLUE << "[Step 3/3]" << RESET << " Checking which positions are settled..." << std::endl;
+        stage.next("Promethee/settling");
+        settleRanking();
+        printApproximation();
+        log() << GREEN << "✔ Ranking confidence computed successfully." << RESET << "\n";
+
+        log() << GREEN << "========== Promethee Algorithm Completed ==========" << RESET << "\n";
+        return true;
+    }
 
     // Step 1: Initialize variables
-    std::cout << BLUE << "[Step 1/4]" << RESET << " Initializing variables..." << std::endl;
-    multicriteriaPreferenceMatrix.resize(data.size(), std::vector<float>(data.size(), -1));
-    std::cout << GREEN << "✔ Variables initialized successfully." << RESET << "\n";
+    log() << BLUE << "[Step 1/4]" << RESET << " Initializing variables..." << std::endl;
+    ProfileScope stage("Promethee/initialization");
+    multicriteriaPreferenceMatrix.resize(nbAlternatives(), std::vector<float>(nbAlternatives(), -1));
+    planCriteria();
+    if (verbose)
+        printCriteriaPlan();
+    log() << GREEN << "✔ Variables initialized successfully." << RESET << "\n";
 
     // Step 2: Process preference matrix
-    std::cout << BLUE << "[Step 2/4]" << RESET << " Calculating the preference matrix..." << std::endl;
+    log() << BLUE << "[Step 2/4]" << RESET << " Calculating the preference matrix..." << std::endl;
+    stage.next("Promethee/preferenceMatrix");
     calculatePreferenceMatrix();
-    std::cout << GREEN << "✔ Preference matrix calculated successfully." << RESET << "\n";
+    log() << GREEN << "✔ Preference matrix calculated successfully." << RESET << "\n";
 
     // Step 3: Compute flows
-    std::cout << BLUE << "[Step 3/4]" << RESET << " Computing positive and negative flows..." << std::endl;
+    log() << BLUE << "[Step 3/4]" << RESET << " Computing positive and negative flows..." << std::endl;
+    stage.next("Promethee/flows");
     calculateFlows();
-    std::cout << GREEN << "✔ Flows computed successfully." << RESET << "\n";
+    log() << GREEN << "✔ Flows computed successfully." << RESET << "\n";
 
     // Step 4: Compute best alternatives
-    std::cout << BLUE << "[Step 4/4]" << RESET << " Computing best alternatives..." << std::endl;
-    bestAlternativesPositive.resize(data.size(), -1);
-    bestAlternativesNegative.resize(data.size(), -1);
-    bestAlternativesOverall.resize(data.size(), -1);
+    log() << BLUE << "[Step 4/4]" << RESET << " Computing best alternatives..." << std::endl;
+    stage.next("Promethee/ranking");
+    bestAlternativesPositive.resize(nbAlternatives(), -1);
+    bestAlternativesNegative.resize(nbAlternatives(), -1);
+    bestAlternativesOverall.resize(nbAlternatives(), -1);
     calculateBestCandidates();
-    std::cout << GREEN << "✔ Best alternatives computed successfully." << RESET << "\n";
+    log() << GREEN << "✔ Best alternatives computed successfully." << RESET << "\n";
 
-    std::cout << GREEN << "========== Promethee Algorithm Completed ==========" << RESET << "\n";
+    log() << GREEN << "========== Promethee Algorithm Completed ==========" << RESET << "\n";
+    return true;
 }
@@ -0,0 +1,377 @@
+#include "../include/ResultCache.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+    // FIPS 180-4 SHA-256
+    class Sha256
+    {
+    public:
+        void update(const void *data, size_t size)
+        {
+            const uint8_t *bytes = (const uint8_t *)data;
+            totalBytes += size;
+            while (size > 0)
+            {
+                size_t chunk = std::min(size, block.size() - blockSize);
+                std::memcpy(block.data() + blockSize, bytes, chunk);
+                blockSize += chunk;
+                bytes += chunk;
+                size -= chunk;
+                if (blockSize == block.size())
+                {
+                    compress();
+                    blockSize = 0;
+                }
+            }
+        }
+
+        std::string hexDigest()
+        {
+            uint64_t bits = totalBytes * 8;
+            uint8_t padding = 0x80;
+            update(&padding, 1);
+            padding = 0;
+            while (blockSize != 56)
+                update(&padding, 1);
+            for (int i = 7; i >= 0; i--)
+            {
+                uint8_t byte = bits >> (8 * i);
+                update(&byte, 1);
+            }
+
+            std::string hex;
+            const char *digits = "0123456789abcdef";
+            for (uint32_t word : state)
+            {
+                for (int i = 28; i >= 0; i -= 4)
+                    hex += digits[(word >> i) & 0xF];
+            }
+            return hex;
+        }
+
+    private:
+        std::array<uint32_t, 8> state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        std::array<uint8_t, 64> block{};
+        size_t blockSize = 0;
+        uint64_t totalBytes = 0;
+
+        void compress()
+        {
+            static constexpr uint32_t K[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+            uint32_t w[64];
+            for (int i = 0; i < 16; i++)
+                w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+            for (int i = 16; i < 64; i++)
+            {
+                uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; i++)
+            {
+                uint32_t t1 = h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+                uint32_t t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+    };
+
+    // Every field is prefixed with its size so that no two different inputs share a byte stream
+    void hashSize(Sha256 &hash, uint64_t size)
+    {
+        hash.update(&size, sizeof(size));
+    }
+
+    void hashString(Sha256 &hash, const std::string &text)
+    {
+        hashSize(hash, text.size());
+        hash.update(text.data(), text.size());
+    }
+
+    void hashFloats(Sha256 &hash, std::span<const float> values)
+    {
+        hashSize(hash, values.size());
+        float buffer[256];
+        for (size_t first = 0; first < values.size(); first += 256)
+        {
+            size_t count = std::min<size_t>(256, values.size() - first);
+            for (size_t i = 0; i < count; i++)
+            {
+                // -0 and 0, and every NaN, give the same results
+                float value = values[first + i];
+                if (value == 0)
+                    value = 0;
+                if (std::isnan(value))
+                    value = std::numeric_limits<float>::quiet_NaN();
+                buffer[i] = value;
+            }
+            hash.update(buffer, count * sizeof(float));
+        }
+    }
+
+    uintmax_t entrySize(const std::filesystem::path &entry)
+    {
+        uintmax_t size = 0;
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(entry, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (it->is_regular_file(error))
+                size += it->file_size(error);
+        }
+        return size;
+    }
+
+    // Each file of the tree is hard linked, or copied when the two directories are on different file systems
+    bool linkTree(const std::filesystem::path &from, const std::filesystem::path &to)
+    {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(from, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (!it->is_regular_file(error))
+                continue;
+            std::filesystem::path target = to / std::filesystem::relative(it->path(), from, error);
+            std::filesystem::create_directories(target.parent_path(), error);
+            std::filesystem::create_hard_link(it->path(), target, error);
+            if (error)
+                std::filesystem::copy_file(it->path(), target, error);
+            if (error)
+                return false;
+        }
+        return !error;
+    }
+
+    // Each file of the tree replaces its namesake, never written through, since it may be linked into an entry
+    bool replaceTree(const std::filesystem::path &from, const std::filesystem::path &to, bool move)
+    {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(from, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (!it->is_regular_file(error))
+                continue;
+            std::filesystem::path target = to / std::filesystem::relative(it->path(), from, error);
+            std::filesystem::create_directories(target.parent_path(), error);
+            if (move)
+            {
+                std::filesystem::rename(it->path(), target, error);
+            }
+            else
+            {
+                std::filesystem::remove(target, error);
+                std::filesystem::copy_file(it->path(), target, error);
+            }
+            if (error)
+                return false;
+        }
+        return !error;
+    }
+}
+
+/**
+ * @brief Cache directory used when none is given.
+ *
+ * @return $XDG_CACHE_HOME/ams-BI, ~/.cache/ams-BI, or an empty path if neither is known.
+ */
+std::filesystem::path ResultCache::defaultDirectory()
+{
+    if (const char *cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome)
+        return std::filesystem::path(cacheHome) / "ams-BI";
+    if (const char *home = std::getenv("HOME"); home && *home)
+        return std::filesystem::path(home) / ".cache" / "ams-BI";
+    return {};
+}
+
+/**
+ * @brief Computes the key of the next run of an algorithm.
+ *
+ * @param algo The configured algorithm.
+ * @return The hexadecimal SHA-256 of the canonical inputs, nothing if the results of this
+ * configuration cannot be reused.
+ */
+std::optional<std::string> ResultCache::key(const Algo &algo) const
+{
+    std::optional<std::string> configuration = algo.cacheConfiguration();
+    if (!configuration)
+        return std::nullopt;
+
+    const Dataset &dataset = *algo.getDataset();
+    Sha256 hash;
+    // Bumped whenever the same inputs give different results, v2: compensated flow reductions
+    hashString(hash, "ams-BI result cache v2");
+    hashString(hash, version);
+    hashString(hash, algo.getName());
+    hashString(hash, *configuration);
+    // Only hashed for the binary formats, so that the CSV keys of older caches stay valid
+    if (algo.getOutputFormat() != CSV)
+        hashString(hash, algo.getOutputFormat() == NPY ? "format=npy" : "format=raw");
+
+    hashSize(hash, dataset.getNbAlternatives());
+    hashSize(hash, dataset.getNbCriteria());
+    for (size_t criterium = 0; criterium < dataset.getNbCriteria(); criterium++)
+        hashFloats(hash, dataset.expandColumn(criterium));
+    hashFloats(hash, dataset.getWeights());
+    hashFloats(hash, dataset.getVetos());
+    hashFloats(hash, dataset.getPreferenceThresholds());
+    hashSize(hash, dataset.getOptimizations().size());
+    for (OptimizationType optimization : dataset.getOptimizations())
+    {
+        uint8_t byte = optimization;
+        hash.update(&byte, 1);
+    }
+    float threshold = dataset.getConcordanceThreshold();
+    hashFloats(hash, std::span<const float>(&threshold, 1));
+    // Only hashed with a label.json, so that the keys of the datasets without one stay valid
+    for (const CriterionLevel &level : dataset.getHierarchy())
+    {
+        hashString(hash, level.label);
+        hashSize(hash, level.groups.size());
+        for (const std::string &group : level.groups)
+            hashString(hash, group);
+        for (int group : level.groupOf)
+            hashSize(hash, group);
+    }
+    return hash.hexDigest();
+}
+
+/**
+ * @brief Copies the files of a cache entry to the output directory.
+ *
+ * @param key The key of the entry.
+ * @param outputDirectory The directory given to save().
+ * @return false on a miss.
+ */
+bool ResultCache::restore(const std::string &key, const std::filesystem::path &outputDirectory)
+{
+    std::filesystem::path entry = directory / key;
+    std::error_code error;
+    if (!std::filesystem::is_directory(entry, error))
+        return false;
+
+    std::filesystem::create_directories(outputDirectory, error);
+    if (!replaceTree(entry, outputDirectory, false))
+        return false;
+
+    // Most recently used entries are evicted last
+    std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), error);
+    return true;
+}
+
+/**
+ * @brief Saves the results of an algorithm into the output directory, then links them into a new
+ * cache entry.
+ *
+ *  save() writes once, into a hidden staging directory of the output directory, so that the entry
+ *  holds exactly the files of this run. They are hard linked into the cache unless they alone
+ *  exceed its size limit, then moved over the previous outputs.
+ *
+ * @param key The key computed before the run.
+ * @param algo The algorithm that just ran.
+ * @param outputDirectory The directory given to save().
+ * @return false if the results could not be saved into the output directory.
+ */
+bool ResultCache::store(const std::string &key, Algo &algo, const std::filesystem::path &outputDirectory)
+{
+    std::error_code error;
+    std::filesystem::create_directories(outputDirectory, error);
+    if (error)
+        return false;
+
+    std::ostringstream stagingName;
+    stagingName << ".tmp-" << key << "-" << getpid() << "-" << std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::filesystem::path outputStaging = outputDirectory / stagingName.str();
+    if (algo.save(outputStaging.string()) < 0)
+    {
+        std::filesystem::remove_all(outputStaging, error);
+        return false;
+    }
+
+    // Linked aside then renamed, so that concurrent runs never see a partial entry
+    if (entrySize(outputStaging) <= maxBytes)
+    {
+        std::filesystem::path staging = directory / stagingName.str();
+        std::filesystem::create_directories(directory, error);
+        if (!error && linkTree(outputStaging, staging))
+            std::filesystem::rename(staging, directory / key, error);
+        std::filesystem::remove_all(staging, error); // Failed, or stored meanwhile by another run
+        evict();
+    }
+
+    bool moved = replaceTree(outputStaging, outputDirectory, true);
+    std::filesystem::remove_all(outputStaging, error);
+    return moved;
+}
+
+/**
+ * @brief Removes the least recently used entries until the cache fits in its size limit.
+ */
+void ResultCache::evict()
+{
+    std::lock_guard<std::mutex> lock(evictionMutex);
+
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUse;
+        uintmax_t size;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code error;
+    for (auto it = std::filesystem::directory_iterator(directory, error); !error && it != std::filesystem::directory_iterator(); it.increment(error))
+    {
+        if (!it->is_directory() || it->path().filename().string().starts_with("."))
+            continue;
+        Entry entry{it->path(), it->last_write_time(), entrySize(it->path())};
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    if (total <= maxBytes)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+              { return a.lastUse < b.lastUse; });
+    for (const Entry &entry : entries)
+    {
+        if (total <= maxBytes)
+            break;
+        std::filesystem::remove_all(entry.path, error);
+        total -= entry.size;
+    }
+}
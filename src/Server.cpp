@@ -0,0 +1,414 @@
+#include "../include/Server.hpp"
+#include "../include/Electre.hpp"
+#include "../include/Parser.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ANSI escape codes for text color
+#define RESET "\033[0m"
+#define GREEN "\033[32m"
+#define BLUE "\033[34m"
+
+/**
+ * @brief Listens on the socket until a shutdown request.
+ *
+ *  Each connection is served by its own thread, which mostly waits on the socket; the algorithms
+ *  run their parallel stages on the shared scheduler.
+ *
+ * @param scheduler The process-wide scheduler.
+ * @return 0 after a shutdown request, 1 if the socket could not be opened.
+ */
+int Server::run(TaskScheduler &scheduler)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Error: socket path too long: " << socketPath << std::endl;
+        return 1;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket < 0)
+    {
+        std::cerr << "Error: socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    unlink(socketPath.c_str());
+    if (bind(listenSocket, (sockaddr *)&address, sizeof(address)) < 0 || listen(listenSocket, SOMAXCONN) < 0)
+    {
+        std::cerr << "Error: " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(listenSocket);
+        return 1;
+    }
+
+    std::cout << GREEN << "========== Serving on " << socketPath << " (" << maxDatasets << " resident datasets, "
+              << scheduler.getThreadCount() << " threads) ==========" << RESET << std::endl;
+
+    while (!stopping)
+    {
+        int client = accept(listenSocket, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (stopping)
+                break;
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            std::cerr << "Error: accept: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            clients.insert(client);
+        }
+        std::thread(&Server::serveConnection, this, client, std::ref(scheduler)).detach();
+    }
+
+    // Wake the connections still waiting for a request, their last response can still be sent
+    close(listenSocket);
+    unlink(socketPath.c_str());
+    std::unique_lock<std::mutex> lock(clientsMutex);
+    for (int client : clients)
+        shutdown(client, SHUT_RD);
+    clientsDone.wait(lock, [this]
+                     { return clients.empty(); });
+
+    std::cout << GREEN << "========== Server stopped ==========" << RESET << std::endl;
+    return 0;
+}
+
+/**
+ * @brief Stops accepting connections.
+ */
+void Server::stop()
+{
+    stopping = true;
+    shutdown(listenSocket, SHUT_RDWR);
+}
+
+/**
+ * @brief Answers the requests of one connection, one line each, until it is closed.
+ *
+ * @param client The connected socket.
+ * @param scheduler The process-wide scheduler.
+ */
+void Server::serveConnection(int client, TaskScheduler &scheduler)
+{
+    std::string pending;
+    char chunk[4096];
+    bool open = true;
+    while (open)
+    {
+        ssize_t received = recv(client, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            break;
+        pending.append(chunk, received);
+
+        size_t newline;
+        while (open && (newline = pending.find('\n')) != std::string::npos)
+        {
+            std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+
+            Json response;
+            try
+            {
+                Json request = Json::parse(line);
+                response = handle(request, scheduler);
+                if (request.contains("id"))
+                    response["id"] = request["id"];
+            }
+            catch (const std::exception &exception)
+            {
+                response = Json::object();
+                response["ok"] = false;
+                response["error"] = exception.what();
+            }
+
+            std::string text = response.dump() + "\n";
+            for (size_t sent = 0; sent < text.size();)
+            {
+                ssize_t written = send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+                if (written <= 0)
+                {
+                    open = false;
+                    break;
+                }
+                sent += written;
+            }
+        }
+
+        if (pending.size() > MAX_REQUEST_BYTES)
+        {
+            std::string text = "{\"ok\":false,\"error\":\"request too long\"}\n";
+            send(client, text.data(), text.size(), MSG_NOSIGNAL);
+            break;
+        }
+    }
+
+    // Closed under the lock so that run() never shuts down a reused descriptor
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    clients.erase(client);
+    close(client);
+    clientsDone.notify_all();
+}
+
+/**
+ * @brief Returns a resident dataset, parsing its directory if it is not loaded yet.
+ *
+ *  The least recently used dataset is evicted when the LRU is full. Requests in flight keep their
+ *  own reference, so an evicted dataset is freed once they are done.
+ *
+ * @param directory The dataset directory, holding at least `donnees.csv`.
+ * @return The resident dataset.
+ */
+std::shared_ptr<Server::LoadedDataset> Server::acquireDataset(const std::string &directory)
+{
+    std::string key = std::filesystem::weakly_canonical(directory).string();
+    {
+        std::lock_guard<std::mutex> lock(datasetsMutex);
+        auto it = datasetIndex.find(key);
+        if (it != datasetIndex.end())
+        {
+            residentDatasets.splice(residentDatasets.begin(), residentDatasets, it->second);
+            return residentDatasets.front();
+        }
+    }
+
+    // Parsed outside of the lock, a concurrent request for the same directory may parse it too
+    if (!std::filesystem::is_regular_file(std::filesystem::path(key) / "donnees.csv"))
+        throw std::runtime_error("no donnees.csv in " + directory);
+    std::ostream silent(nullptr);
+    Parser parser;
+    parser.setOutput(silent);
+    parser.parseDirectory(key);
+    auto loaded = std::make_shared<LoadedDataset>();
+    loaded->directory = key;
+    loaded->dataset = parser.getDataset();
+
+    std::lock_guard<std::mutex> lock(datasetsMutex);
+    auto it = datasetIndex.find(key);
+    if (it != datasetIndex.end())
+    {
+        residentDatasets.splice(residentDatasets.begin(), residentDatasets, it->second);
+        return residentDatasets.front();
+    }
+    residentDatasets.push_front(loaded);
+    datasetIndex[key] = residentDatasets.begin();
+    while (residentDatasets.size() > maxDatasets)
+    {
+        datasetIndex.erase(residentDatasets.back()->directory);
+        residentDatasets.pop_back();
+    }
+    return loaded;
+}
+
+/**
+ * @brief Returns the outranking counts of every criterion of a dataset, computing them once.
+ *
+ * @param loaded The resident dataset.
+ * @param scheduler The process-wide scheduler.
+ * @return The counts, criterion by criterion.
+ */
+std::shared_ptr<const std::vector<CriterionCounts>> Server::countsOf(LoadedDataset &loaded, TaskScheduler &scheduler)
+{
+    std::lock_guard<std::mutex> lock(loaded.countsMutex);
+    if (!loaded.counts)
+    {
+        const Dataset &dataset = *loaded.dataset;
+        auto counts = std::make_shared<std::vector<CriterionCounts>>(dataset.getNbCriteria());
+        scheduler.parallelFor(0, counts->size(), 1, [&](size_t first, size_t last)
+                              {
+            for (size_t k = first; k < last; ++k)
+                Promethee::countOutranked(dataset.expandColumn(k), (*counts)[k].below, (*counts)[k].above); });
+        loaded.counts = counts;
+    }
+    return loaded.counts;
+}
+
+/**
+ * @brief Lists the resident datasets.
+ *
+ * @return The stats response.
+ */
+Json Server::stats()
+{
+    Json datasets = Json::array();
+    std::lock_guard<std::mutex> lock(datasetsMutex);
+    for (const auto &loaded : residentDatasets)
+    {
+        Json entry = Json::object();
+        entry["dataset"] = loaded->directory;
+        entry["alternatives"] = loaded->dataset->getNbAlternatives();
+        entry["criteria"] = loaded->dataset->getNbCriteria();
+        std::lock_guard<std::mutex> countsLock(loaded->countsMutex);
+        entry["counts"] = loaded->counts != nullptr;
+        datasets.push(entry);
+    }
+
+    Json response = Json::object();
+    response["ok"] = true;
+    response["capacity"] = maxDatasets;
+    response["datasets"] = datasets;
+    return response;
+}
+
+/**
+ * @brief Runs one request.
+ *
+ * @param request The parsed request.
+ * @param scheduler The process-wide scheduler.
+ * @return The response, errors are thrown as std::runtime_error.
+ */
+Json Server::handle(const Json &request, TaskScheduler &scheduler)
+{
+    std::string op = request.contains("op") ? request["op"].asString() : "rank";
+    Json response = Json::object();
+    if (op == "shutdown")
+    {
+        stop();
+        response["ok"] = true;
+        return response;
+    }
+    if (op == "stats")
+        return stats();
+    if (op != "rank")
+        throw std::runtime_error("unknown op: " + op);
+
+    if (!request.contains("dataset"))
+        throw std::runtime_error("missing dataset");
+    std::shared_ptr<LoadedDataset> loaded = acquireDataset(request["dataset"].asString());
+
+    // Overrides are applied on a copy sharing the resident values; each needs one entry per
+    // criterion, the kernels index them without bounds checks
+    auto dataset = std::make_shared<Dataset>(*loaded->dataset);
+    auto perCriterion = [&](const std::string &key) -> const std::vector<Json> &
+    {
+        const std::vector<Json> &items = request[key].asArray();
+        if (items.size() != dataset->getNbCriteria())
+            throw std::runtime_error(key + " has " + std::to_string(items.size()) + " entries, the dataset has " +
+                                     std::to_string(dataset->getNbCriteria()) + " criteria");
+        return items;
+    };
+    if (request.contains("weights"))
+    {
+        perCriterion("weights");
+        dataset->setWeights(request["weights"].asFloats());
+    }
+    if (request.contains("vetos"))
+    {
+        perCriterion("vetos");
+        dataset->setVetos(request["vetos"].asFloats());
+    }
+    if (request.contains("preferences"))
+    {
+        perCriterion("preferences");
+        dataset->setPreferenceThresholds(request["preferences"].asFloats());
+    }
+    if (request.contains("threshold"))
+        dataset->setConcordanceThreshold(request["threshold"].asNumber());
+    if (request.contains("optimizations"))
+    {
+        std::vector<OptimizationType> optimizations;
+        for (const Json &item : perCriterion("optimizations"))
+        {
+            if (item.asString() == "max")
+                optimizations.push_back(MAX);
+            else if (item.asString() == "min")
+                optimizations.push_back(MIN);
+            else
+                throw std::runtime_error("optimizations must be \"max\" or \"min\"");
+        }
+        dataset->setOptimizations(optimizations);
+    }
+    if (dataset->getWeights().empty())
+        throw std::runtime_error("no weights for this dataset");
+
+    std::ostream silent(nullptr);
+    std::string algorithm = request.contains("algorithm") ? request["algorithm"].asString() : "promethee";
+    if (algorithm == "promethee" || algorithm == "p")
+    {
+        Promethee promethee;
+        promethee.setOutput(silent);
+        promethee.setDataset(dataset);
+        promethee.setOutrankingCounts(countsOf(*loaded, scheduler));
+        promethee.run(scheduler);
+
+        const std::vector<int> &positions = promethee.getBestAlternativesOverall();
+        std::vector<int> ranking(positions.size());
+        std::iota(ranking.begin(), ranking.end(), 0);
+        std::stable_sort(ranking.begin(), ranking.end(), [&](int a, int b)
+                         { return positions[a] < positions[b]; });
+        for (int &alternative : ranking)
+            alternative++;
+
+        response["ok"] = true;
+        response["algorithm"] = "promethee";
+        response["flows"] = Json::array(promethee.getFlows());
+        response["positions"] = Json::array(positions);
+        response["ranking"] = Json::array(ranking);
+
+        // Per level of label.json, the net flow of each group for every alternative
+        std::span<const CriterionLevel> hierarchy = dataset->getHierarchy();
+        const std::vector<std::vector<float>> &partialFlows = promethee.getPartialFlows();
+        if (!partialFlows.empty())
+        {
+            Json levels = Json::object();
+            for (size_t level = 0; level < partialFlows.size(); ++level)
+            {
+                size_t groups = hierarchy[level].groups.size();
+                Json groupFlows = Json::object();
+                for (size_t g = 0; g < groups; ++g)
+                {
+                    Json values = Json::array();
+                    for (size_t i = 0; i < positions.size(); ++i)
+                        values.push(partialFlows[level][i * groups + g]);
+                    groupFlows[hierarchy[level].groups[g]] = values;
+                }
+                levels[hierarchy[level].label] = groupFlows;
+            }
+            response["partialFlows"] = levels;
+        }
+    }
+    else if (algorithm == "electre" || algorithm == "e")
+    {
+        if (dataset->getVetos().empty() || dataset->getOptimizations().empty())
+            throw std::runtime_error("electre needs vetos and optimizations");
+
+        Electre electre;
+        electre.setOutput(silent);
+        electre.setDataset(dataset);
+        if (!electre.run(scheduler))
+            throw std::runtime_error("electre failed");
+
+        std::vector<int> kernel;
+        std::vector<bool> inKernel = electre.getKernel();
+        for (size_t i = 0; i < inKernel.size(); ++i)
+        {
+            if (inKernel[i])
+                kernel.push_back(i + 1);
+        }
+
+        response["ok"] = true;
+        response["algorithm"] = "electre";
+        response["kernel"] = Json::array(kernel);
+    }
+    else
+    {
+        throw std::runtime_error("unknown algorithm: " + algorithm);
+    }
+    return response;
+}
@@ -0,0 +1,276 @@
+#include "../include/TaskScheduler.hpp"
+#include <algorithm>
+#include <chrono>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Worker of the current thread, -1 outside of any pool
+static thread_local TaskScheduler *currentScheduler = nullptr;
+static thread_local int currentWorker = -1;
+
+/**
+ * @brief Starts the workers.
+ *
+ * @param threadCount Total number of threads doing work, including the thread that waits.
+ * @param pinThreads Pin each worker to one of the cores the process may run on (Linux only).
+ */
+TaskScheduler::TaskScheduler(int threadCount, bool pinThreads)
+{
+    int workerCount = std::max(1, threadCount) - 1;
+    for (int i = 0; i <= workerCount; i++)
+        queues.push_back(std::make_unique<TaskQueue>());
+
+    // The cores allowed by the affinity mask, e.g. those of a cgroup or of taskset
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (pinThreads && sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&TaskScheduler::workerLoop, this, i, cpus.empty() ? -1 : cpus[i % cpus.size()]);
+}
+
+/**
+ * @brief Stops the workers once they are idle.
+ */
+TaskScheduler::~TaskScheduler()
+{
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeUp.notify_all();
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+/**
+ * @brief Number of threads used when none is requested.
+ *
+ * @return The number of hardware threads, at least 1.
+ */
+int TaskScheduler::defaultThreadCount()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Queues a task, on the deque of the current worker when called from the pool.
+ *
+ * @param task The task to run.
+ */
+void TaskScheduler::submit(Task task)
+{
+    size_t index = (currentScheduler == this && currentWorker >= 0) ? currentWorker : queues.size() - 1;
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    queuedTasks++;
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    wakeUp.notify_one();
+}
+
+/**
+ * @brief Takes the next task: newest of the own deque, then the injection queue, then the oldest of another worker.
+ *
+ * @param task Receives the task.
+ * @return false if no task is queued anywhere.
+ */
+bool TaskScheduler::popTask(Task &task)
+{
+    if (queuedTasks == 0)
+        return false;
+
+    size_t count = queues.size();
+    size_t own = (currentScheduler == this && currentWorker >= 0) ? currentWorker : count - 1;
+    for (size_t offset = 0; offset < count; offset++)
+    {
+        size_t index = (own + offset) % count;
+        TaskQueue &queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        if (offset == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queuedTasks--;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Runs a task unless its group was cancelled, and records its exception.
+ *
+ * @param task The task to run.
+ */
+void TaskScheduler::execute(Task &task)
+{
+    TaskGroup *group = task.group;
+    if (!group->isCancelled())
+    {
+        try
+        {
+            task.function();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(group->errorMutex);
+            if (!group->error)
+                group->error = std::current_exception();
+            group->cancel();
+        }
+    }
+    task.function = nullptr;
+
+    if (--group->pending == 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeUp.notify_all();
+    }
+}
+
+/**
+ * @brief Runs one queued task if there is any.
+ *
+ * @return true if a task was run.
+ */
+bool TaskScheduler::runOne()
+{
+    Task task;
+    if (!popTask(task))
+        return false;
+    execute(task);
+    return true;
+}
+
+/**
+ * @brief Main loop of a worker.
+ *
+ * @param index The index of the worker and of its deque.
+ * @param cpu The core to pin the worker to, -1 to leave it unpinned.
+ */
+void TaskScheduler::workerLoop(int index, int cpu)
+{
+    currentScheduler = this;
+    currentWorker = index;
+
+#ifdef __linux__
+    if (cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+
+    while (!stopping)
+    {
+        if (runOne())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]
+                    { return stopping || queuedTasks > 0; });
+    }
+}
+
+/**
+ * @brief Adds a task to the group.
+ *
+ * @param task The task to run.
+ */
+void TaskScheduler::TaskGroup::run(std::function<void()> task)
+{
+    pending++;
+    scheduler.submit({std::move(task), this});
+}
+
+/**
+ * @brief Waits for every task of the group, running queued tasks meanwhile.
+ *
+ *  Rethrows the first exception thrown by a task of the group.
+ */
+void TaskScheduler::TaskGroup::wait()
+{
+    drain();
+
+    std::exception_ptr thrown;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        std::swap(thrown, error);
+    }
+    if (thrown)
+        std::rethrow_exception(thrown);
+}
+
+/**
+ * @brief Waits for every task of the group without rethrowing their exceptions.
+ */
+void TaskScheduler::TaskGroup::drain()
+{
+    while (pending > 0)
+    {
+        if (scheduler.runOne())
+            continue;
+
+        // The remaining tasks are running on other threads
+        std::unique_lock<std::mutex> lock(scheduler.sleepMutex);
+        scheduler.wakeUp.wait_for(lock, std::chrono::microseconds(200), [this]
+                                  { return pending == 0 || scheduler.queuedTasks > 0; });
+    }
+}
+
+/**
+ * @brief Runs body over [begin, end) split in chunks of `grain` indexes.
+ *
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param grain Indexes per chunk, 0 to pick about 8 chunks per thread.
+ * @param body Called with the bounds of each chunk.
+ * @param stopToken Chunks that have not started yet are skipped once stop is requested.
+ */
+void TaskScheduler::parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body, std::stop_token stopToken)
+{
+    if (begin >= end)
+        return;
+    if (grain == 0)
+        grain = std::max<size_t>(1, (end - begin) / (8 * getThreadCount()));
+    if (end - begin <= grain || getThreadCount() == 1)
+    {
+        if (!stopToken.stop_requested())
+            body(begin, end);
+        return;
+    }
+
+    TaskGroup group(*this);
+    for (size_t chunk = begin; chunk < end; chunk += grain)
+    {
+        size_t chunkEnd = std::min(end, chunk + grain);
+        group.run([&body, &stopToken, chunk, chunkEnd]
+                  {
+            if (!stopToken.stop_requested())
+                body(chunk, chunkEnd); });
+    }
+    group.wait();
+}
@@ -0,0 +1,162 @@
+#include "../include/TileStore.hpp"
+#include <iostream>
+#include <unistd.h>
+
+// A token with this bit set encodes a run of empty words, otherwise it is followed by that many literal words
+static constexpr uint64_t ZERO_RUN = uint64_t(1) << 63;
+
+/**
+ * @brief Creates the scratch file of the store.
+ *
+ * @param directory The scratch directory, created if needed; if that fails, every write fails.
+ * @param nbColumns The number of columns of the matrix.
+ */
+TileStore::TileStore(const std::filesystem::path &directory, size_t nbColumns)
+    : nbColumns(nbColumns), wordsPerRow((nbColumns + 63) / 64)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    filePath = directory / ("dominance-" + std::to_string(getpid()) + "-" + std::to_string((uintptr_t)this) + ".tiles");
+    output.open(filePath, std::ios::binary | std::ios::trunc);
+    if (!output)
+        std::cerr << "Error creating scratch file: " << filePath << std::endl;
+}
+
+/**
+ * @brief Removes the scratch file.
+ */
+TileStore::~TileStore()
+{
+    if (output.is_open())
+        output.close();
+    std::error_code error;
+    std::filesystem::remove(filePath, error);
+}
+
+/**
+ * @brief Run-length encodes the empty words of a bitmap.
+ *
+ * @param words The bitmap words.
+ * @param count The number of words to encode.
+ * @param encoded Receives the encoded tokens.
+ */
+void TileStore::compress(const std::vector<uint64_t> &words, size_t count, std::vector<uint64_t> &encoded)
+{
+    encoded.clear();
+    size_t i = 0;
+    while (i < count)
+    {
+        size_t start = i;
+        if (words[i] == 0)
+        {
+            while (i < count && words[i] == 0)
+                i++;
+            encoded.push_back(ZERO_RUN | (i - start));
+            continue;
+        }
+
+        while (i < count && words[i] != 0)
+            i++;
+        encoded.push_back(i - start);
+        encoded.insert(encoded.end(), words.begin() + start, words.begin() + i);
+    }
+}
+
+/**
+ * @brief Decodes a run-length encoded bitmap.
+ *
+ * @param encoded The encoded tokens.
+ * @param words Receives the bitmap words; it must already have the decoded size.
+ */
+void TileStore::decompress(const std::vector<uint64_t> &encoded, std::vector<uint64_t> &words)
+{
+    size_t out = 0;
+    size_t i = 0;
+    while (i < encoded.size())
+    {
+        uint64_t token = encoded[i++];
+        size_t count = token & ~ZERO_RUN;
+        if (token & ZERO_RUN)
+        {
+            std::fill(words.begin() + out, words.begin() + out + count, 0);
+        }
+        else
+        {
+            std::copy(encoded.begin() + i, encoded.begin() + i + count, words.begin() + out);
+            i += count;
+        }
+        out += count;
+    }
+}
+
+/**
+ * @brief Compresses and appends a tile to the scratch file.
+ *
+ * @param firstRow The index of the first row of the tile.
+ * @param rowCount The number of rows of the tile.
+ * @param bits The packed rows, `rowCount * getWordsPerRow()` words.
+ * @return false if the scratch file could not be written, e.g. because its disk is full.
+ */
+bool TileStore::writeTile(size_t firstRow, size_t rowCount, const std::vector<uint64_t> &bits)
+{
+    std::vector<uint64_t> encoded;
+    compress(bits, rowCount * wordsPerRow, encoded);
+    if (!output.write(reinterpret_cast<const char *>(encoded.data()), encoded.size() * sizeof(uint64_t)))
+    {
+        std::cerr << "Error writing scratch file: " << filePath << std::endl;
+        return false;
+    }
+    bytesWritten += encoded.size() * sizeof(uint64_t);
+    tiles.push_back({firstRow, rowCount, encoded.size()});
+    return true;
+}
+
+/**
+ * @brief Flushes the scratch file once all the tiles are written.
+ *
+ * @return false if the buffered tiles could not be written.
+ */
+bool TileStore::finish()
+{
+    if (!output.flush())
+    {
+        std::cerr << "Error writing scratch file: " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads every tile back in order and visits each row.
+ *
+ * @param buffer Decoding buffer, reused between tiles and between calls.
+ * @param visit Called with the row index and its packed bits.
+ * @return false if the scratch file could not be read back entirely, the rows visited so far are
+ *         then only part of the matrix.
+ */
+bool TileStore::stream(std::vector<uint64_t> &buffer, const std::function<void(size_t row, const uint64_t *bits)> &visit) const
+{
+    std::ifstream input(filePath, std::ios::binary);
+    if (!input)
+    {
+        std::cerr << "Error reading scratch file: " << filePath << std::endl;
+        return false;
+    }
+
+    std::vector<uint64_t> encoded;
+    for (const TileInfo &tile : tiles)
+    {
+        encoded.resize(tile.encodedWords);
+        if (!input.read(reinterpret_cast<char *>(encoded.data()), encoded.size() * sizeof(uint64_t)))
+        {
+            std::cerr << "Error reading scratch file: " << filePath << " is truncated" << std::endl;
+            return false;
+        }
+        buffer.resize(tile.rowCount * wordsPerRow);
+        decompress(encoded, buffer);
+
+        for (size_t row = 0; row < tile.rowCount; row++)
+            visit(tile.firstRow + row, buffer.data() + row * wordsPerRow);
+    }
+    return true;
+}
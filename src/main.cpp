@@ -3,10 +3,17 @@
 #include <memory>
 #include <string.h>
 #include <filesystem>
+#include <mutex>
+#include <atomic>
+#include <sstream>
 #include "../include/Parser.hpp"
 #include "../include/Electre.hpp"
 #include "../include/Promethee.hpp"
 #include "../include/Algo.hpp"
+#include "../include/Batch.hpp"
+#include "../include/Server.hpp"
+#include "../include/ResultCache.hpp"
+#include "../include/Profiler.hpp"
 // #include "../include/OptimizationType.hpp"
 
 // ANSI escape codes for text color
@@ -38,6 +45,36 @@ auto warning = [](std::string_view message)
     std::cerr << "⚠️ Warning: " << message << " ⚠️\n";
 };
 
+/**
+ * @brief Parses a byte count with an optional K, M or G suffix (powers of 1024).
+ *
+ * @return The number of bytes, or 0 if the value is not a valid size.
+ */
+size_t parse_size(const std::string &value)
+{
+    size_t end = 0;
+    double number;
+    try
+    {
+        number = std::stod(value, &end);
+    }
+    catch (const std::exception &)
+    {
+        return 0;
+    }
+    std::string suffix = value.substr(end);
+    double multiplier = 1;
+    if (suffix == "K" || suffix == "k")
+        multiplier = 1024.0;
+    else if (suffix == "M" || suffix == "m")
+        multiplier = 1024.0 * 1024;
+    else if (suffix == "G" || suffix == "g")
+        multiplier = 1024.0 * 1024 * 1024;
+    else if (!suffix.empty())
+        return 0;
+    return number > 0 ? (size_t)(number * multiplier) : 0;
+}
+
 void print_usage(const std::vector<std::unique_ptr<Algo>> &algo)
 {
     std::cout << std::endl
@@ -48,6 +85,27 @@ void print_usage(const std::vector<std::unique_ptr<Algo>> &algo)
               << "          -s | --save                     Path to the output file" << std::endl
               << "          -d | --data                     Path to data CSV file" << std::endl
               << "          -w | --weight                   Path to weight CSV file" << std::endl
+              << "          -l | --labels                   Path to the criteria hierarchy (label.json): weights without -w, per-group Promethee flows" << std::endl
+              << "               --skyline                  Electre: skip Pareto-dominated candidates before the pairwise stages" << std::endl
+              << "                                          (dropped when a dominated candidate outranks another one, same kernel)" << std::endl
+              << "               --stream                   Promethee: compute the flows while reading the data file, one criterion per line" << std::endl
+              << "               --threads                  Number of threads shared by all the algorithms (default: all cores)" << std::endl
+              << "               --pin                      Pin each worker thread to one of the cores the process may use" << std::endl
+              << "               --batch                    Run every dataset directory below this root, saving under -s with the same layout" << std::endl
+              << "               --serve                    Answer JSON requests on this Unix socket, keeping the datasets resident" << std::endl
+              << "               --max-datasets             Datasets kept resident by --serve (default 8)" << std::endl
+              << "               --approx                   Promethee: estimate the flows from sampled opponents (anytime)" << std::endl
+              << "               --deadline-ms              Promethee: time budget of the approximation (default 100, implies --approx)" << std::endl
+              << "               --epsilon                  Promethee: stop the approximation once φ/(n-1) is known within ±epsilon (implies --approx)" << std::endl
+              << "               --top-k                    Promethee: number of approximate positions reported (default 10)" << std::endl
+              << "               --mem-limit                Electre: peak memory for the matrixes (e.g. 512M, 4G), runs out-of-core above it" << std::endl
+              << "               --scratch                  Electre: directory for the out-of-core tiles (default: system temp)" << std::endl
+              << "               --no-cache                 Always run the algorithms, even if the same inputs were already saved" << std::endl
+              << "               --cache-dir                Directory of the result cache (default: ~/.cache/ams-BI)" << std::endl
+              << "               --cache-size               Size limit of the result cache, larger results are not cached (default 256M)" << std::endl
+              << "               --format                   Format of the saved results: csv, npy or raw (mmap-able, described by manifest.json) (default csv)" << std::endl
+              << "               --profile                  Write the time, CPU, allocations and peak memory of every stage to this JSON file" << std::endl
+              << "               --verbose                  Print details about the computation (e.g. Promethee criteria plan)" << std::endl
               << "          -a | --algo                     Choose the algorithm that you want to run : " << std::endl;
     for (const auto &a : algo)
     {
@@ -91,6 +149,30 @@ int main(int argc, char **argv)
     std::string concordanceThresholdFile = "";
     bool isConcordanceThresholdFile = false;
 
+    std::string hierarchyFile = "";
+    bool isHierarchyFile = false;
+
+    bool useSkyline = false;
+    size_t memoryLimit = 0;
+
+    bool useStreaming = false;
+    int threads = TaskScheduler::defaultThreadCount();
+    bool pinThreads = false;
+
+    bool useApproximation = false;
+    double deadlineMs = 100;
+    double epsilon = 0;
+    int topK = 10;
+    std::string scratchDirectory = "";
+    std::string batchRoot = "";
+    std::string serveSocket = "";
+    size_t maxDatasets = 8;
+    bool useCache = true;
+    std::string cacheDirectory = ResultCache::defaultDirectory().string();
+    size_t cacheSize = 256 * 1024 * 1024;
+    std::string profileFile = "";
+    OutputFormat outputFormat = CSV;
+
     // Arg parser
     if (argc < 0)
     {
@@ -109,6 +191,105 @@ int main(int argc, char **argv)
             print_release();
             return 0;
         }
+        else if (!strcmp(argv[i], "--skyline"))
+        {
+            useSkyline = true;
+        }
+        else if (!strcmp(argv[i], "--stream"))
+        {
+            useStreaming = true;
+        }
+        else if (!strcmp(argv[i], "--threads"))
+        {
+            threads = std::stoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--pin"))
+        {
+            pinThreads = true;
+        }
+        else if (!strcmp(argv[i], "--batch"))
+        {
+            batchRoot = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--serve"))
+        {
+            serveSocket = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--max-datasets"))
+        {
+            maxDatasets = std::stoul(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--approx"))
+        {
+            useApproximation = true;
+        }
+        else if (!strcmp(argv[i], "--deadline-ms"))
+        {
+            deadlineMs = std::stod(argv[++i]);
+            useApproximation = true;
+        }
+        else if (!strcmp(argv[i], "--epsilon"))
+        {
+            epsilon = std::stod(argv[++i]);
+            useApproximation = true;
+        }
+        else if (!strcmp(argv[i], "--top-k"))
+        {
+            topK = std::stoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--mem-limit"))
+        {
+            memoryLimit = parse_size(argv[++i]);
+            if (memoryLimit == 0)
+            {
+                failure("Invalid --mem-limit value: " + std::string(argv[i]));
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--scratch"))
+        {
+            scratchDirectory = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--no-cache"))
+        {
+            useCache = false;
+        }
+        else if (!strcmp(argv[i], "--cache-dir"))
+        {
+            cacheDirectory = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--cache-size"))
+        {
+            cacheSize = parse_size(argv[++i]);
+            if (cacheSize == 0)
+            {
+                failure("Invalid --cache-size value: " + std::string(argv[i]));
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--format"))
+        {
+            std::string format = argv[++i];
+            if (format == "csv")
+                outputFormat = CSV;
+            else if (format == "npy")
+                outputFormat = NPY;
+            else if (format == "raw")
+                outputFormat = RAW;
+            else
+            {
+                failure("Invalid --format value: " + format + " (csv, npy or raw)");
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--profile"))
+        {
+            profileFile = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--verbose"))
+        {
+            VERBOSE = true;
+        }
         else if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--save"))
         {
             outputFile = argv[++i];
@@ -138,6 +319,11 @@ int main(int argc, char **argv)
             optimizationsFile = argv[++i];
             isOptimizationsFile = true;
         }
+        else if (!strcmp(argv[i], "-l") || !strcmp(argv[i], "--labels"))
+        {
+            hierarchyFile = argv[++i];
+            isHierarchyFile = true;
+        }
         else if (!strcmp(argv[i], "-ct") || !strcmp(argv[i], "--concordance_threshold"))
         {
             concordanceThresholdFile = argv[++i];
@@ -184,25 +370,92 @@ int main(int argc, char **argv)
         }
     }
 
+    // Enabled for the rest of main(), the report is written when it returns
+    std::string commandLine = argv[0];
+    for (int i = 1; i < argc; i++)
+    {
+        commandLine += " " + std::string(argv[i]);
+    }
+    ProfileSession profileSession(profileFile, commandLine);
+
+    if (serveSocket != "")
+    {
+        TaskScheduler scheduler(threads, pinThreads);
+        Server server(serveSocket, maxDatasets);
+        return server.run(scheduler);
+    }
+
+    if (batchRoot != "")
+    {
+        BatchOptions options;
+        options.algorithms = "";
+        for (const auto &algo : availableAlgos)
+        {
+            if (algoToRun == "a" || algoToRun.find(algo->getArgName()) != std::string::npos)
+                options.algorithms += algo->getArgName();
+        }
+        options.outputRoot = outputFile;
+        options.verbose = VERBOSE;
+        options.useSkyline = useSkyline;
+        options.memoryLimit = memoryLimit;
+        options.scratchDirectory = scratchDirectory;
+        options.useStreaming = useStreaming;
+        options.useApproximation = useApproximation;
+        options.deadlineMs = deadlineMs;
+        options.epsilon = epsilon;
+        options.topK = topK;
+        options.format = outputFormat;
+
+        TaskScheduler scheduler(threads, pinThreads);
+        Batch batch(batchRoot, options);
+        return batch.run(scheduler);
+    }
+
     Parser parser;
-    if (!isFile && !isWeightFile)
+    if (!isFile && !isWeightFile && !isHierarchyFile)
     {
         failure("You must specify a dataset file and/or weight file.");
         return 1;
     }
 
-    if (isFile)
     {
-        parser.parseFile(filename);
-    }
-    if (isWeightFile)
-    {
-        parser.parseWeightFile(filenameWeight);
+        ProfileScope parsing("parse");
+
+        // The streaming Promethee pipeline reads the data file itself
+        if (isFile && !(useStreaming && algoToRun == "p"))
+        {
+            parser.parseFile(filename);
+        }
+        if (isWeightFile)
+        {
+            parser.parseWeightFile(filenameWeight);
+        }
+        if (isVetosFile)
+        {
+            parser.parseVetosFile(vetosFile);
+        }
+        if (isOptimizationsFile)
+        {
+            parser.parseOptimizationsFile(optimizationsFile);
+        }
+        if (isConcordanceThresholdFile)
+        {
+            parser.parseConcordanceThresholdFile(concordanceThresholdFile);
+        }
+        if (isPreferencesFile)
+        {
+            parser.parsePreferencesFile(preferencesFile);
+        }
+        if (isHierarchyFile)
+        {
+            parser.parseHierarchyFile(hierarchyFile);
+        }
     }
 
-    std::vector<std::vector<float>> data = parser.getParsedFile();
-    std::vector<float> weights = parser.getParsedWeight();
+    // Parsed once, borrowed by every algorithm
+    std::shared_ptr<const Dataset> dataset = parser.getDataset();
 
+    std::vector<Algo *> selectedAlgos;
     for (const char c : algoToRun)
     {
         auto it = std::find_if(availableAlgos.begin(), availableAlgos.end(),
@@ -211,7 +464,13 @@ int main(int argc, char **argv)
 
         if (it != availableAlgos.end())
         {
-            std::cout << BLUE << "\033[1mExecuting: " << (*it)->getName() << RESET << std::endl;
+            if (std::find(selectedAlgos.begin(), selectedAlgos.end(), it->get()) != selectedAlgos.end())
+            {
+                warning((*it)->getName() + " is selected more than once, running it once.");
+                continue;
+            }
+            (*it)->setVerbose(VERBOSE);
+            (*it)->setOutputFormat(outputFormat);
 
             if (auto *electre = dynamic_cast<Electre *>(it->get()))
             {
@@ -220,52 +479,40 @@ int main(int argc, char **argv)
                     std::cerr << "You must specify a veto file when using the Electre method." << std::endl; 
                     continue;
                 }
-                parser.parseVetosFile(vetosFile);
-                std::vector<float> vetos = parser.getParsedVetosFile();
 
                 if (!isOptimizationsFile)
                 {
                     std::cerr << "You must specify an optimization file when using the Electre method." << std::endl; 
                     continue;
                 }
-                parser.parseOptimizationsFile(optimizationsFile);
-                std::vector<OptimizationType> optimizations = parser.getParsedOptimizationsFile();
 
                 if (!isConcordanceThresholdFile)
                 {
                     std::cerr << "You must specify a concordance threshold file when using the Electre method." << std::endl; 
                     continue;
                 }                
-                parser.parseConcordanceThresholdFile(concordanceThresholdFile);
-                float concordanceThreshold = parser.getParsedConcordanceThresholdFile();
-
-                electre->setData(data);
-                electre->setWeights(weights);
-                electre->setVetos(vetos);
-                electre->setConcordanceThreshold(concordanceThreshold);
-                if (isPreferencesFile)
-                {
-                    parser.parsePreferencesFile(preferencesFile);
-                    std::vector<float> preferences = parser.getParsedPreferencesFile();
-                    electre->setPreferenceThresholds(preferences);
-                }
-                electre->setOptimizations(optimizations);
-                electre->run();
-                if (outputFile != "")
+
+                electre->setDataset(dataset);
+                electre->setSkylinePrefilter(useSkyline);
+                electre->setMemoryLimit(memoryLimit);
+                if (scratchDirectory != "")
                 {
-                    electre->save(outputFile);
+                    electre->setScratchDirectory(scratchDirectory);
                 }
             }
             else if (auto *promethee = dynamic_cast<Promethee *>(it->get()))
             {
-                promethee->setData(data);
-                promethee->setWeights(weights);
-                promethee->run();
-                if (outputFile != "")
+                promethee->setDataset(dataset);
+                if (useApproximation)
+                {
+                    promethee->setApproximation(deadlineMs, epsilon, topK);
+                }
+                if (useStreaming)
                 {
-                promethee->save(outputFile);
+                    promethee->setStreamingSource(filename);
                 }
             }
+            selectedAlgos.push_back(it->get());
         }
         else
         {
@@ -273,5 +520,79 @@ int main(int argc, char **argv)
         }
     }
 
-    return 0;
+    // Every parallel stage of every algorithm runs on this pool
+    TaskScheduler scheduler(threads, pinThreads);
+
+    // Only the saved results are cached, a run without -s always computes
+    std::unique_ptr<ResultCache> cache;
+    if (useCache && outputFile != "" && cacheDirectory != "")
+    {
+        cache = std::make_unique<ResultCache>(cacheDirectory, cacheSize, RELEASE);
+    }
+
+    std::mutex saveMutex;
+    std::atomic<bool> failed = false;
+    auto execute = [&](Algo *algo, std::ostream &output)
+    {
+        algo->setOutput(output);
+        output << BLUE << "\033[1mExecuting: " << algo->getName() << RESET << std::endl;
+
+        std::optional<std::string> key;
+        if (cache)
+        {
+            key = cache->key(*algo);
+        }
+        if (key && cache->restore(*key, outputFile))
+        {
+            output << GREEN << "✔ Results served from the cache (" << key->substr(0, 12) << ")." << RESET << std::endl;
+            algo->setOutput(std::cout);
+            return;
+        }
+
+        std::string stageName = algo->getName();
+        std::string saveName = stageName + "/save";
+        ProfileScope stage(stageName.c_str());
+        if (!algo->run(scheduler))
+        {
+            // A failed run saves nothing, so that neither the output folder nor the cache holds its results
+            output << RED << "✘ " << algo->getName() << " failed, nothing saved." << RESET << std::endl;
+            failed = true;
+            algo->setOutput(std::cout);
+            return;
+        }
+        if (outputFile != "")
+        {
+            std::lock_guard<std::mutex> lock(saveMutex);
+            stage.next(saveName.c_str());
+            if (!key || !cache->store(*key, *algo, outputFile))
+            {
+                algo->save(outputFile);
+            }
+        }
+        algo->setOutput(std::cout);
+    };
+
+    if (selectedAlgos.size() == 1)
+    {
+        execute(selectedAlgos[0], std::cout);
+        return failed ? 1 : 0;
+    }
+
+    // The algorithms only read the shared dataset: they run as tasks of the same pool as their own
+    // parallel stages, each printing into its own buffer that is flushed to the console as a whole
+    // once the algorithm is done
+    std::mutex consoleMutex;
+    TaskScheduler::TaskGroup running(scheduler);
+    for (Algo *algo : selectedAlgos)
+    {
+        running.run([&, algo]
+                    {
+            std::ostringstream buffer;
+            execute(algo, buffer);
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cout << buffer.str() << std::flush; });
+    }
+    running.wait();
+
+    return failed ? 1 : 0;
 }
@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// ANSI escape codes for text color
+#define RESET "\033[0m"
+#define GREEN "\033[32m"
+#define BLUE "\033[34m"
+
+enum Distribution
+{
+    INDEPENDENT,    // Every value uniform
+    CORRELATED,     // An alternative good on one criterion is good on the others
+    ANTICORRELATED, // An alternative good on one criterion is bad on the others, large skylines
+    ORDINAL,        // Few distinct integer levels per criterion
+    DUPLICATES      // Copies of a small pool of distinct alternatives
+};
+
+struct GenOptions
+{
+    size_t alternatives = 1000;
+    size_t criteria = 10;
+    Distribution distribution = INDEPENDENT;
+    unsigned long seed = 42;
+    int levels = 5;             // ORDINAL: distinct values per criterion
+    double uniqueShare = 0.1;   // DUPLICATES: share of distinct alternatives
+    double minShare = 0;        // Share of the criteria to minimise
+    double veto = 0.6;          // Share of the value range
+    double preference = 0.05;   // Share of the value range
+    double concordanceThreshold = 0.7;
+    std::filesystem::path output = "";
+};
+
+/**
+ * @brief Generates the decision matrix, one criterion per line like donnees.csv.
+ *
+ *  Values are drawn as a "quality" in [0, 1] per alternative and criterion, following the
+ *  distributions of the skyline literature, then mapped to [0, 100] (or to 1..levels), reversed on
+ *  the criteria to minimise so that the correlation holds between what is good on each criterion.
+ *
+ * @param options The generation parameters.
+ * @param minimise Whether each criterion is minimised.
+ * @return The values, criterion-major.
+ */
+std::vector<float> generate_values(const GenOptions &options, const std::vector<bool> &minimise)
+{
+    size_t n = options.alternatives;
+    size_t m = options.criteria;
+    std::mt19937_64 generator(options.seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::normal_distribution<double> plane(0.5, 0.15);
+    std::normal_distribution<double> spread(0, 0.05);
+
+    auto clamp = [](double value)
+    { return std::clamp(value, 0.0, 1.0); };
+
+    std::vector<double> quality(n * m); // quality[c * n + a]
+    std::vector<double> row(m);
+    size_t distinct = options.distribution == DUPLICATES ? std::max<size_t>(1, std::llround(n * options.uniqueShare)) : n;
+    for (size_t a = 0; a < distinct; a++)
+    {
+        switch (options.distribution)
+        {
+        case CORRELATED:
+        {
+            double center = clamp(plane(generator));
+            for (double &value : row)
+                value = clamp(center + spread(generator));
+            break;
+        }
+        case ANTICORRELATED:
+        {
+            // Points scattered around the hyperplane sum = m * center, redrawn until inside the cube
+            double center = clamp(0.5 + spread(generator));
+            bool inside = false;
+            while (!inside)
+            {
+                double mean = 0;
+                for (double &value : row)
+                    mean += value = uniform(generator);
+                mean /= m;
+                inside = true;
+                for (double &value : row)
+                {
+                    value += center - mean;
+                    inside = inside && value >= 0 && value <= 1;
+                }
+            }
+            break;
+        }
+        default:
+            for (double &value : row)
+                value = uniform(generator);
+        }
+        for (size_t c = 0; c < m; c++)
+            quality[c * n + a] = row[c];
+    }
+
+    // The remaining alternatives are copies of the distinct ones
+    std::uniform_int_distribution<size_t> pick(0, distinct - 1);
+    for (size_t a = distinct; a < n; a++)
+    {
+        size_t source = pick(generator);
+        for (size_t c = 0; c < m; c++)
+            quality[c * n + a] = quality[c * n + source];
+    }
+    if (distinct < n)
+    {
+        std::vector<size_t> order(n);
+        for (size_t a = 0; a < n; a++)
+            order[a] = a;
+        std::shuffle(order.begin(), order.end(), generator);
+        std::vector<double> shuffled(n * m);
+        for (size_t c = 0; c < m; c++)
+        {
+            for (size_t a = 0; a < n; a++)
+                shuffled[c * n + a] = quality[c * n + order[a]];
+        }
+        quality.swap(shuffled);
+    }
+
+    std::vector<float> values(n * m);
+    for (size_t c = 0; c < m; c++)
+    {
+        for (size_t a = 0; a < n; a++)
+        {
+            double q = minimise[c] ? 1 - quality[c * n + a] : quality[c * n + a];
+            if (options.distribution == ORDINAL)
+                values[c * n + a] = 1 + std::min<int>(options.levels - 1, q * options.levels);
+            else
+                values[c * n + a] = std::round(q * 10000) / 100; // Two decimals keep the files small
+        }
+    }
+    return values;
+}
+
+void append_float(std::string &line, float value)
+{
+    char buffer[32];
+    auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    line.append(buffer, end);
+}
+
+/**
+ * @brief Writes one comma-separated line.
+ *
+ * @return false if the file could not be written.
+ */
+bool write_line(const std::filesystem::path &path, const std::vector<float> &values)
+{
+    std::string line;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (i)
+            line += ',';
+        append_float(line, values[i]);
+    }
+    std::ofstream file(path);
+    file << line << "\n";
+    return (bool)file;
+}
+
+/**
+ * @brief Writes a dataset directory in the layout of data/cars.
+ *
+ * @param options The generation parameters.
+ * @return 0 on success, 1 if a file could not be written.
+ */
+int write_dataset(const GenOptions &options)
+{
+    size_t n = options.alternatives;
+    size_t m = options.criteria;
+    std::mt19937_64 generator(options.seed ^ 0x9e3779b97f4a7c15ULL);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    // The first minShare * m criteria of a random order are minimised
+    std::vector<size_t> order(m);
+    for (size_t c = 0; c < m; c++)
+        order[c] = c;
+    std::shuffle(order.begin(), order.end(), generator);
+    std::vector<bool> minimise(m, false);
+    size_t minimised = std::llround(m * options.minShare); // minShare is checked to be in [0, 1]
+    for (size_t i = 0; i < minimised; i++)
+        minimise[order[i]] = true;
+
+    std::error_code error;
+    std::filesystem::create_directories(options.output, error);
+    if (error)
+    {
+        std::cerr << "Error: " << options.output.string() << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    std::cout << BLUE << "[Step 1/2]" << RESET << " Generating " << n << " alternatives on " << m << " criteria..." << std::endl;
+    std::vector<float> values = generate_values(options, minimise);
+
+    std::cout << BLUE << "[Step 2/2]" << RESET << " Writing " << options.output.string() << "..." << std::endl;
+    {
+        std::ofstream data(options.output / "donnees.csv");
+        std::string line;
+        for (size_t c = 0; c < m && data; c++)
+        {
+            line.clear();
+            for (size_t a = 0; a < n; a++)
+            {
+                if (a)
+                    line += ',';
+                append_float(line, values[c * n + a]);
+            }
+            line += '\n';
+            data << line;
+        }
+        if (!data)
+        {
+            std::cerr << "Error: " << (options.output / "donnees.csv").string() << std::endl;
+            return 1;
+        }
+    }
+
+    // The parser normalises the weights
+    std::vector<float> weights(m);
+    for (float &weight : weights)
+        weight = std::round((1 + 9 * uniform(generator)) * 100) / 100;
+
+    float range = options.distribution == ORDINAL ? options.levels - 1 : 100;
+    std::vector<float> vetos(m, range * options.veto);
+    std::vector<float> preferences(m, range * options.preference);
+
+    std::string optimizations;
+    for (size_t c = 0; c < m; c++)
+        optimizations += std::string(c ? "," : "") + (minimise[c] ? "MIN" : "MAX");
+
+    bool written = write_line(options.output / "weight.csv", weights) &&
+                   write_line(options.output / "vetos.csv", vetos) &&
+                   write_line(options.output / "preferences.csv", preferences) &&
+                   write_line(options.output / "seuilconcordance.csv", {(float)options.concordanceThreshold});
+    std::ofstream optimizationsFile(options.output / "optimizations.csv");
+    optimizationsFile << optimizations << "\n";
+    if (!written || !optimizationsFile)
+    {
+        std::cerr << "Error: could not write the parameter files in " << options.output.string() << std::endl;
+        return 1;
+    }
+
+    std::cout << GREEN << "✔ Dataset written successfully." << RESET << std::endl;
+    return 0;
+}
+
+void print_usage()
+{
+    std::cout << "\033[1mUsage: \033[0mams-gen -o <directory> [options]" << std::endl
+              << "          -h | --help                     Help" << std::endl
+              << "          -o | --output                   Dataset directory to write (donnees.csv, weight.csv, vetos.csv, ...)" << std::endl
+              << "          -n | --alternatives             Number of alternatives (default 1000)" << std::endl
+              << "          -m | --criteria                 Number of criteria (default 10)" << std::endl
+              << "               --dist                     independent, correlated, anticorrelated, ordinal or duplicates (default independent)" << std::endl
+              << "               --seed                     Seed of the generator (default 42)" << std::endl
+              << "               --levels                   ordinal: distinct values per criterion (default 5)" << std::endl
+              << "               --unique                   duplicates: share of distinct alternatives (default 0.1)" << std::endl
+              << "               --min-share                Share of the criteria to minimise (default 0)" << std::endl
+              << "               --veto                     Vetos, as a share of the value range (default 0.6)" << std::endl
+              << "               --preference               Preference thresholds, as a share of the value range (default 0.05)" << std::endl
+              << "               --threshold                Concordance threshold (default 0.7)" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    GenOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help"))
+        {
+            print_usage();
+            return 0;
+        }
+        else if ((!strcmp(argv[i], "-o") || !strcmp(argv[i], "--output")) && hasValue)
+            options.output = argv[++i];
+        else if ((!strcmp(argv[i], "-n") || !strcmp(argv[i], "--alternatives")) && hasValue)
+            options.alternatives = std::stoul(argv[++i]);
+        else if ((!strcmp(argv[i], "-m") || !strcmp(argv[i], "--criteria")) && hasValue)
+            options.criteria = std::stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--dist") && hasValue)
+        {
+            std::string name = argv[++i];
+            if (name == "independent")
+                options.distribution = INDEPENDENT;
+            else if (name == "correlated")
+                options.distribution = CORRELATED;
+            else if (name == "anticorrelated")
+                options.distribution = ANTICORRELATED;
+            else if (name == "ordinal")
+                options.distribution = ORDINAL;
+            else if (name == "duplicates")
+                options.distribution = DUPLICATES;
+            else
+            {
+                std::cerr << "Error: unknown distribution: " << name << std::endl;
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--seed") && hasValue)
+            options.seed = std::stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--levels") && hasValue)
+            options.levels = std::stoi(argv[++i]);
+        else if (!strcmp(argv[i], "--unique") && hasValue)
+            options.uniqueShare = std::stod(argv[++i]);
+        else if (!strcmp(argv[i], "--min-share") && hasValue)
+            options.minShare = std::stod(argv[++i]);
+        else if (!strcmp(argv[i], "--veto") && hasValue)
+            options.veto = std::stod(argv[++i]);
+        else if (!strcmp(argv[i], "--preference") && hasValue)
+            options.preference = std::stod(argv[++i]);
+        else if (!strcmp(argv[i], "--threshold") && hasValue)
+            options.concordanceThreshold = std::stod(argv[++i]);
+        else
+        {
+            print_usage();
+            std::cerr << "Error: unknown or incomplete argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.output.empty() || options.alternatives < 1 || options.criteria < 1 || options.levels < 1 ||
+        options.uniqueShare <= 0 || options.uniqueShare > 1 || options.minShare < 0 || options.minShare > 1)
+    {
+        print_usage();
+        std::cerr << "Error: an output directory, at least one alternative, criterion and level, and shares within [0, 1] are required" << std::endl;
+        return 1;
+    }
+    return write_dataset(options);
+}
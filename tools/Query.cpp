@@ -0,0 +1,438 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/Json.hpp"
+
+/**
+ * @brief An array of a manifest.json, mapped read-only.
+ *
+ *  Matrixes are addressed by row and column. Bit-packed arrays (the Electre dominance) are
+ *  addressed by their logical shape, one bit per pair.
+ */
+struct MappedArray
+{
+    std::string name;
+    std::string dtype; // "<f4", "<i4" or "|u1"
+    size_t rows = 0;
+    size_t columns = 0; // 1 for the vectors
+    bool matrix = false;
+    bool packedBits = false;
+    const uint8_t *data = nullptr;
+    size_t rowBytes = 0;
+
+    double at(size_t row, size_t column) const
+    {
+        const uint8_t *cell = data + row * rowBytes;
+        if (packedBits)
+            return (cell[column / 8] >> (column % 8)) & 1;
+        if (dtype == "<f4")
+        {
+            float value;
+            std::memcpy(&value, cell + column * 4, 4);
+            return value;
+        }
+        if (dtype == "<i4")
+        {
+            int value;
+            std::memcpy(&value, cell + column * 4, 4);
+            return value;
+        }
+        return cell[column];
+    }
+};
+
+/**
+ * @brief The result directory of one algorithm, as written by `ams-BI --format npy|raw`.
+ *
+ *  Alternatives are numbered from 1 like in the CSV rankings. When the matrixes only cover the
+ *  skyline candidates, the "candidates" array maps the alternatives to their rows.
+ */
+class ResultIndex
+{
+public:
+    ~ResultIndex()
+    {
+        for (auto [mapping, length] : mappings)
+            munmap(mapping, length);
+    }
+
+    bool open(const std::filesystem::path &directory);
+    const MappedArray *find(const std::string &name) const;
+    bool position(const MappedArray &array, long alternative, size_t &index, std::string &error, bool column = false) const;
+    long alternativeAt(const MappedArray &array, size_t index) const;
+    const std::vector<MappedArray> &getArrays() const { return arrays; }
+
+private:
+    std::vector<MappedArray> arrays;
+    std::vector<std::pair<void *, size_t>> mappings;
+    std::vector<int> candidates;     // Original 0-based indexes of the matrix rows, empty if all
+    std::vector<long> rowOfCandidate; // -1 for the alternatives outside the candidates
+};
+
+/**
+ * @brief Maps every array listed in the manifest of a directory.
+ *
+ * @return false if the manifest or an array is missing or inconsistent.
+ */
+bool ResultIndex::open(const std::filesystem::path &directory)
+{
+    Json manifest;
+    try
+    {
+        std::ifstream file(directory / "manifest.json");
+        std::stringstream text;
+        text << file.rdbuf();
+        manifest = Json::parse(text.str());
+
+        for (const Json &entry : manifest["arrays"].asArray())
+        {
+            MappedArray array;
+            array.name = entry["name"].asString();
+            array.dtype = entry["dtype"].asString();
+            std::filesystem::path path = directory / entry["file"].asString();
+            size_t offset = entry["offset"].asNumber();
+
+            const std::vector<Json> &shape = entry["shape"].asArray();
+            if (shape.empty() || shape.size() > 2)
+                throw std::runtime_error(array.name + ": only vectors and matrixes are supported");
+            array.rows = shape[0].asNumber();
+            array.matrix = shape.size() == 2;
+            size_t storedColumns = array.matrix ? (size_t)shape[1].asNumber() : 1;
+            size_t itemBytes = array.dtype == "|u1" ? 1 : 4;
+            array.rowBytes = storedColumns * itemBytes;
+            array.columns = storedColumns;
+            if (entry.contains("logicalShape"))
+            {
+                array.packedBits = true;
+                array.columns = entry["logicalShape"].asArray()[1].asNumber();
+            }
+
+            size_t length = offset + array.rows * array.rowBytes;
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat status;
+            if (fd < 0 || fstat(fd, &status) != 0 || (size_t)status.st_size < length)
+            {
+                if (fd >= 0)
+                    close(fd);
+                throw std::runtime_error(path.string() + ": missing or shorter than its manifest entry");
+            }
+            if (length > 0)
+            {
+                void *mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    close(fd);
+                    throw std::runtime_error("mmap " + path.string() + ": " + strerror(errno));
+                }
+                mappings.push_back({mapping, length});
+                array.data = (const uint8_t *)mapping + offset;
+            }
+            close(fd);
+            arrays.push_back(array);
+        }
+    }
+    catch (const std::exception &exception)
+    {
+        std::cerr << "Error: " << (directory / "manifest.json").string() << ": " << exception.what() << std::endl;
+        return false;
+    }
+
+    if (const MappedArray *list = find("candidates"))
+    {
+        long largest = -1;
+        for (size_t i = 0; i < list->rows; i++)
+        {
+            candidates.push_back((int)list->at(i, 0));
+            largest = std::max<long>(largest, candidates.back());
+        }
+        rowOfCandidate.assign(largest + 1, -1);
+        for (size_t i = 0; i < candidates.size(); i++)
+            rowOfCandidate[candidates[i]] = i;
+    }
+    return true;
+}
+
+const MappedArray *ResultIndex::find(const std::string &name) const
+{
+    for (const MappedArray &array : arrays)
+    {
+        if (array.name == name)
+            return &array;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Finds the row (or column) of an alternative in an array.
+ *
+ *  The columns of the partial flows are groups of criteria, numbered from 1 too.
+ *
+ * @param array The array.
+ * @param alternative The alternative, numbered from 1.
+ * @param index Set to its row.
+ * @param error Set to the reason when it has none.
+ * @param column Whether the column is looked for.
+ * @return Whether the alternative is in the array.
+ */
+bool ResultIndex::position(const MappedArray &array, long alternative, size_t &index, std::string &error, bool column) const
+{
+    if (alternative < 1)
+    {
+        error = "alternatives are numbered from 1";
+        return false;
+    }
+    size_t original = alternative - 1;
+    if (column && array.matrix && array.columns != array.rows)
+    {
+        if (original >= array.columns)
+        {
+            error = "column " + std::to_string(alternative) + " out of range (" + std::to_string(array.columns) + ")";
+            return false;
+        }
+        index = original;
+        return true;
+    }
+    // The matrixes of a skyline run only cover its candidates, the vectors every alternative
+    if (array.matrix && !candidates.empty())
+    {
+        if (original >= rowOfCandidate.size() || rowOfCandidate[original] < 0)
+        {
+            error = "alternative " + std::to_string(alternative) + " is not a skyline candidate";
+            return false;
+        }
+        index = rowOfCandidate[original];
+        return true;
+    }
+    if (original >= array.rows)
+    {
+        error = "alternative " + std::to_string(alternative) + " out of range (" + std::to_string(array.rows) + ")";
+        return false;
+    }
+    index = original;
+    return true;
+}
+
+long ResultIndex::alternativeAt(const MappedArray &array, size_t index) const
+{
+    return (array.matrix && !candidates.empty() ? candidates[index] : (long)index) + 1;
+}
+
+void append_value(std::string &out, const MappedArray &array, double value)
+{
+    char digits[32];
+    auto [end, error] = array.dtype == "<f4" ? std::to_chars(digits, digits + sizeof(digits), (float)value)
+                                             : std::to_chars(digits, digits + sizeof(digits), (long)value);
+    out.append(digits, end);
+}
+
+/**
+ * @brief Answers one query, on one line.
+ *
+ *  at ARRAY A          Value of a vector for alternative A
+ *  pair ARRAY A B      Cell (A, B) of a matrix
+ *  row ARRAY A         Row of A, comma-separated
+ *  col ARRAY B         Column of B, comma-separated
+ *  top ARRAY A K       The K largest cells of the row of A, as alternative:value, in decreasing order
+ *  list                The arrays, as name:dtype:rows×columns
+ *
+ * @param index The mapped results.
+ * @param query The query.
+ * @param out Where the answer is appended, with its line ending.
+ * @return false, with the answer being an empty line, if the query is invalid.
+ */
+bool answer(const ResultIndex &index, const std::string &query, std::string &out)
+{
+    std::istringstream words(query);
+    std::string command, name;
+    words >> command;
+
+    std::string error;
+    if (command == "list")
+    {
+        for (const MappedArray &array : index.getArrays())
+        {
+            out += (&array == &index.getArrays()[0] ? "" : ",") + array.name + ":" + array.dtype + ":" + std::to_string(array.rows);
+            if (array.matrix)
+                out += "x" + std::to_string(array.columns);
+        }
+        out += '\n';
+        return true;
+    }
+
+    words >> name;
+    const MappedArray *array = index.find(name);
+    long first = 0, second = 0;
+    size_t row = 0, column = 0;
+    bool matrixCommand = command == "pair" || command == "row" || command == "col" || command == "top";
+
+    if (command != "at" && !matrixCommand)
+        error = "unknown query: " + command;
+    else if (!array)
+        error = "no array named " + name;
+    else if (array->matrix != matrixCommand)
+        error = name + (array->matrix ? " is a matrix" : " is a vector");
+    else if (!(words >> first))
+        error = "missing alternative";
+    else if ((command == "pair" || command == "top") && !(words >> second))
+        error = command == "pair" ? "missing second alternative" : "missing count";
+    else if (command != "col" && index.position(*array, first, row, error))
+    {
+        if (command == "pair" && index.position(*array, second, column, error, true))
+            append_value(out, *array, array->at(row, column));
+        else if (command == "at")
+            append_value(out, *array, array->at(row, 0));
+        else if (command == "row")
+        {
+            for (size_t c = 0; c < array->columns; c++)
+            {
+                if (c)
+                    out += ',';
+                append_value(out, *array, array->at(row, c));
+            }
+        }
+        else if (command == "top")
+        {
+            // Alternatives against alternatives, unless the columns are groups of criteria
+            bool square = array->columns == array->rows;
+            std::vector<std::pair<double, size_t>> cells;
+            cells.reserve(array->columns);
+            for (size_t c = 0; c < array->columns; c++)
+            {
+                if (c != row || !square)
+                    cells.push_back({array->at(row, c), c});
+            }
+            size_t k = std::min<size_t>(std::max(second, 0L), cells.size());
+            // Ties in column order, like the rankings
+            std::partial_sort(cells.begin(), cells.begin() + k, cells.end(), [](const auto &a, const auto &b)
+                              { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+            for (size_t i = 0; i < k; i++)
+            {
+                if (i)
+                    out += ',';
+                out += std::to_string(square ? index.alternativeAt(*array, cells[i].second) : (long)cells[i].second + 1) + ':';
+                append_value(out, *array, cells[i].first);
+            }
+        }
+    }
+    else if (command == "col" && index.position(*array, first, column, error, true))
+    {
+        for (size_t r = 0; r < array->rows; r++)
+        {
+            if (r)
+                out += ',';
+            append_value(out, *array, array->at(r, column));
+        }
+    }
+
+    out += '\n';
+    if (!error.empty())
+    {
+        std::cerr << "Error: " << query << ": " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void write_out(std::string &out)
+{
+    std::cout.write(out.data(), out.size());
+    out.clear();
+}
+
+void print_usage()
+{
+    std::cout << "\033[1mUsage: \033[0mams-query [options] <result directory> [query]" << std::endl
+              << "       The directory is one written by ams-BI --format npy|raw, e.g. out/Promethee. Without a query," << std::endl
+              << "       queries are read from stdin, one per line, and answered one per line." << std::endl
+              << "          -h | --help                     Help" << std::endl
+              << "               --timing                   Print the number of queries and their mean time on stderr" << std::endl
+              << "       Queries (alternatives numbered from 1):" << std::endl
+              << "          list                            Arrays of the directory" << std::endl
+              << "          at <array> <a>                  Value of a vector, e.g. at flow 3" << std::endl
+              << "          pair <array> <a> <b>            Cell of a matrix, e.g. pair multicriteriaPreferenceMatrix 3 7" << std::endl
+              << "          row <array> <a>                 Row of a matrix" << std::endl
+              << "          col <array> <b>                 Column of a matrix" << std::endl
+              << "          top <array> <a> <k>             k largest cells of a row, as alternative:value" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::filesystem::path directory;
+    std::string query;
+    bool timing = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help"))
+        {
+            print_usage();
+            return 0;
+        }
+        else if (!strcmp(argv[i], "--timing"))
+            timing = true;
+        else if (directory.empty())
+            directory = argv[i];
+        else
+            query += std::string(query.empty() ? "" : " ") + argv[i];
+    }
+    if (directory.empty())
+    {
+        print_usage();
+        std::cerr << "Error: a result directory is required" << std::endl;
+        return 1;
+    }
+
+    ResultIndex index;
+    if (!index.open(directory))
+        return 1;
+
+    std::ios::sync_with_stdio(false);
+    std::string out;
+    size_t count = 0;
+    bool ok = true;
+    std::chrono::steady_clock::duration spent{};
+
+    auto run = [&](const std::string &line)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ok = answer(index, line, out) && ok;
+        spent += std::chrono::steady_clock::now() - start;
+        count++;
+    };
+
+    if (!query.empty())
+        run(query);
+    else
+    {
+        std::string line;
+        while (std::getline(std::cin, line))
+        {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            run(line);
+            // Answered as soon as the pending queries are, so that a client can wait for each line
+            if (out.size() >= (1 << 16) || std::cin.rdbuf()->in_avail() <= 0)
+            {
+                write_out(out);
+                std::cout.flush();
+            }
+        }
+    }
+    write_out(out);
+    std::cout.flush();
+
+    if (timing && count > 0)
+        std::cerr << count << " queries, " << std::chrono::duration<double, std::micro>(spent).count() / count << " µs per query" << std::endl;
+    return ok ? 0 : 1;
+}
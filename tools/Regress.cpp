@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../include/Json.hpp"
+
+// ANSI escape codes for text color
+#define RESET "\033[0m"
+#define RED "\033[31m"
+#define GREEN "\033[32m"
+#define YELLOW "\033[33m"
+#define BLUE "\033[34m"
+
+extern char **environ;
+
+struct RegressOptions
+{
+    std::filesystem::path configFile = "regress/scales.json";
+    std::filesystem::path goldenRoot = "regress/golden";
+    std::filesystem::path workRoot = std::filesystem::temp_directory_path() / "ams-regress";
+    std::string binary = "./ams-BI";
+    std::string generator = "./ams-gen";
+    std::vector<std::string> extraArgs; // Passed to every run, e.g. --skyline or --threads 4
+    std::string filter = "";
+    std::string reportFile = "";
+    std::string baselineFile = "";
+    int repeat = 3;
+    bool update = false;
+};
+
+struct RunResult
+{
+    bool ok = false;
+    double wallMs = 0;
+    long peakRssKb = 0;
+};
+
+/**
+ * @brief Runs a program to completion with its output discarded.
+ *
+ * @param arguments The program then its arguments.
+ * @return Whether it exited with 0, its wall time and its peak resident memory.
+ */
+RunResult run_program(const std::vector<std::string> &arguments)
+{
+    std::vector<char *> argv;
+    for (const std::string &argument : arguments)
+        argv.push_back(const_cast<char *>(argument.c_str()));
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    RunResult result;
+    pid_t pid;
+    auto start = std::chrono::steady_clock::now();
+    int error = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0)
+    {
+        std::cerr << "Error: " << arguments[0] << ": " << strerror(error) << std::endl;
+        return result;
+    }
+
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    result.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.peakRssKb = usage.ru_maxrss;
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return result;
+}
+
+std::string read_file(const std::filesystem::path &path)
+{
+    std::ifstream file(path);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+/**
+ * @brief Compares an output file with its golden copy, numbers within a tolerance.
+ *
+ *  Both files are split on commas, semicolons and newlines; cells that parse as numbers must be
+ *  within `tolerance` of each other, relatively to the larger magnitude (absolutely below 1),
+ *  the other cells must be identical.
+ *
+ * @param golden The golden file.
+ * @param actual The file written by the run.
+ * @param tolerance 0 for an exact comparison.
+ * @param report Where the first differences are described.
+ * @return Whether the files match.
+ */
+bool compare_files(const std::filesystem::path &golden, const std::filesystem::path &actual, double tolerance, std::ostream &report)
+{
+    if (!std::filesystem::exists(actual))
+    {
+        report << "\t\t" << actual.string() << " was not written\n";
+        return false;
+    }
+
+    auto split = [](const std::string &text)
+    {
+        std::vector<std::pair<std::string, size_t>> cells; // Cell and line
+        std::string cell;
+        size_t line = 1;
+        for (char c : text)
+        {
+            if (c == ',' || c == ';' || c == '\n')
+            {
+                cells.push_back({cell, line});
+                cell.clear();
+                line += c == '\n';
+            }
+            else if (c != '\r')
+                cell += c;
+        }
+        if (!cell.empty())
+            cells.push_back({cell, line});
+        return cells;
+    };
+    auto expected = split(read_file(golden));
+    auto found = split(read_file(actual));
+
+    size_t differences = 0;
+    for (size_t i = 0; i < std::max(expected.size(), found.size()); i++)
+    {
+        if (i >= expected.size() || i >= found.size())
+        {
+            report << "\t\t" << actual.filename().string() << ": " << expected.size() << " cells expected, " << found.size() << " found\n";
+            return false;
+        }
+
+        const std::string &a = expected[i].first;
+        const std::string &b = found[i].first;
+        double x, y;
+        auto [endA, errorA] = std::from_chars(a.data(), a.data() + a.size(), x);
+        auto [endB, errorB] = std::from_chars(b.data(), b.data() + b.size(), y);
+        bool numbers = errorA == std::errc() && errorB == std::errc() && endA == a.data() + a.size() && endB == b.data() + b.size();
+        bool same = numbers ? std::abs(x - y) <= tolerance * std::max({1.0, std::abs(x), std::abs(y)}) : a == b;
+        if (!same && differences++ < 5)
+            report << "\t\t" << actual.filename().string() << " line " << found[i].second << ": expected " << a << ", got " << b << "\n";
+    }
+    if (differences > 5)
+        report << "\t\t" << actual.filename().string() << ": " << differences - 5 << " more differences\n";
+    return differences == 0;
+}
+
+/**
+ * @brief Runs the scales of the configuration and checks their results and performance.
+ *
+ * @param options The command line options.
+ * @return 0 if every scale passed, 1 otherwise.
+ */
+int run_scales(const RegressOptions &options)
+{
+    Json config;
+    Json baseline;
+    try
+    {
+        config = Json::parse(read_file(options.configFile));
+        if (options.baselineFile != "")
+            baseline = Json::parse(read_file(options.baselineFile));
+    }
+    catch (const std::exception &exception)
+    {
+        std::cerr << "Error: " << exception.what() << std::endl;
+        return 1;
+    }
+    double defaultTolerance = config.contains("tolerance") ? config["tolerance"].asNumber() : 1e-4;
+    double maxSlowdown = config.contains("maxSlowdown") ? config["maxSlowdown"].asNumber() : 1.5;
+    double maxMemoryGrowth = config.contains("maxMemoryGrowth") ? config["maxMemoryGrowth"].asNumber() : 1.25;
+
+    std::cout << GREEN << "========== Regression runs of " << options.binary << " ==========" << RESET << std::endl;
+
+    Json scales = Json::array();
+    int failures = 0;
+    for (const Json &scale : config["scales"].asArray())
+    {
+        std::string name = scale["name"].asString();
+        if (options.filter != "" && name.find(options.filter) == std::string::npos)
+            continue;
+        size_t n = scale["n"].asNumber();
+        size_t m = scale["m"].asNumber();
+        std::string algorithms = scale.contains("algorithms") ? scale["algorithms"].asString() : "ep";
+        std::cout << BLUE << "[" << name << "]" << RESET << " n=" << n << " m=" << m << " -a " << algorithms << std::endl;
+
+        // Generated the same way on every machine, only the outputs are stored
+        std::filesystem::path data = options.workRoot / name / "data";
+        std::filesystem::path output = options.workRoot / name / "output";
+        std::vector<std::string> generate = {options.generator, "-o", data.string(), "-n", std::to_string(n), "-m", std::to_string(m)};
+        for (const char *key : {"dist", "seed", "levels", "unique", "min-share", "veto", "preference", "threshold"})
+        {
+            if (scale.contains(key))
+            {
+                const Json &value = scale[key];
+                std::ostringstream text;
+                if (value.getType() == Json::STRING)
+                    text << value.asString();
+                else
+                    text << value.asNumber();
+                generate.insert(generate.end(), {std::string("--") + key, text.str()});
+            }
+        }
+        if (!run_program(generate).ok)
+        {
+            std::cerr << "Error: " << options.generator << " failed for " << name << std::endl;
+            return 1;
+        }
+
+        std::vector<std::string> command = {options.binary, "-a", algorithms, "--no-cache",
+                                            "-d", (data / "donnees.csv").string(), "-w", (data / "weight.csv").string(),
+                                            "-V", (data / "vetos.csv").string(), "-o", (data / "optimizations.csv").string(),
+                                            "-ct", (data / "seuilconcordance.csv").string(), "-p", (data / "preferences.csv").string(),
+                                            "-s", output.string()};
+        command.insert(command.end(), options.extraArgs.begin(), options.extraArgs.end());
+
+        std::vector<double> wallTimes;
+        long peakRssKb = 0;
+        bool ran = true;
+        for (int i = 0; i < options.repeat && ran; i++)
+        {
+            std::filesystem::remove_all(output);
+            RunResult result = run_program(command);
+            ran = result.ok;
+            wallTimes.push_back(result.wallMs);
+            peakRssKb = std::max(peakRssKb, result.peakRssKb);
+        }
+        std::sort(wallTimes.begin(), wallTimes.end());
+        double wallMs = wallTimes[wallTimes.size() / 2];
+        double throughput = n / (wallMs / 1000);
+
+        std::ostringstream report;
+        bool resultsOk = ran;
+        if (!ran)
+            report << "\t\t" << options.binary << " exited with an error\n";
+
+        std::filesystem::path golden = options.goldenRoot / name;
+        for (const Json &file : scale["files"].asArray())
+        {
+            std::string path = file.getType() == Json::STRING ? file.asString() : file["path"].asString();
+            double tolerance = file.getType() == Json::OBJECT && file.contains("tolerance") ? file["tolerance"].asNumber() : defaultTolerance;
+            if (!ran)
+                break;
+            if (options.update)
+            {
+                std::filesystem::create_directories((golden / path).parent_path());
+                std::filesystem::copy_file(output / path, golden / path, std::filesystem::copy_options::overwrite_existing);
+                continue;
+            }
+            if (!std::filesystem::exists(golden / path))
+            {
+                report << "\t\t" << (golden / path).string() << " has no golden copy, run with --update\n";
+                resultsOk = false;
+                continue;
+            }
+            resultsOk = compare_files(golden / path, output / path, tolerance, report) && resultsOk;
+        }
+
+        // Absolute bounds from the configuration, relative ones from an earlier report of the same machine
+        bool performanceOk = true;
+        if (scale.contains("maxWallMs") && wallMs > scale["maxWallMs"].asNumber())
+        {
+            report << "\t\twall time " << wallMs << " ms above the bound of " << scale["maxWallMs"].asNumber() << " ms\n";
+            performanceOk = false;
+        }
+        if (scale.contains("maxPeakRssKb") && peakRssKb > scale["maxPeakRssKb"].asNumber())
+        {
+            report << "\t\tpeak memory " << peakRssKb << " KB above the bound of " << scale["maxPeakRssKb"].asNumber() << " KB\n";
+            performanceOk = false;
+        }
+        if (!baseline.isNull())
+        {
+            for (const Json &previous : baseline["scales"].asArray())
+            {
+                if (previous["name"].asString() != name)
+                    continue;
+                if (wallMs > previous["wallMs"].asNumber() * maxSlowdown)
+                {
+                    report << "\t\twall time " << wallMs << " ms, more than " << maxSlowdown << "x the baseline " << previous["wallMs"].asNumber() << " ms\n";
+                    performanceOk = false;
+                }
+                if (peakRssKb > previous["peakRssKb"].asNumber() * maxMemoryGrowth)
+                {
+                    report << "\t\tpeak memory " << peakRssKb << " KB, more than " << maxMemoryGrowth << "x the baseline " << previous["peakRssKb"].asNumber() << " KB\n";
+                    performanceOk = false;
+                }
+            }
+        }
+
+        const char *status = options.update && ran ? YELLOW "updated" RESET : resultsOk && performanceOk ? GREEN "ok" RESET : RED "FAILED" RESET;
+        std::cout << "\t" << status << "  " << wallMs << " ms, " << (long)throughput << " alternatives/s, " << peakRssKb << " KB peak" << std::endl
+                  << report.str();
+        if (!(options.update ? ran : resultsOk && performanceOk))
+            failures++;
+
+        Json entry = Json::object();
+        entry["name"] = name;
+        entry["n"] = n;
+        entry["m"] = m;
+        entry["wallMs"] = wallMs;
+        entry["alternativesPerSecond"] = throughput;
+        entry["peakRssKb"] = (size_t)peakRssKb;
+        entry["results"] = resultsOk;
+        entry["performance"] = performanceOk;
+        scales.push(entry);
+    }
+
+    if (options.reportFile != "")
+    {
+        Json report = Json::object();
+        report["binary"] = options.binary;
+        report["scales"] = scales;
+        std::ofstream file(options.reportFile);
+        file << report.dump() << "\n";
+        if (!file)
+        {
+            std::cerr << "Error: " << options.reportFile << std::endl;
+            return 1;
+        }
+    }
+
+    if (failures > 0)
+    {
+        std::cout << RED << "========== " << failures << " scale(s) regressed ==========" << RESET << std::endl;
+        return 1;
+    }
+    std::cout << GREEN << "========== No regression ==========" << RESET << std::endl;
+    return 0;
+}
+
+void print_usage()
+{
+    std::cout << "\033[1mUsage: \033[0mams-regress [options] [-- ams-BI arguments]" << std::endl
+              << "          -h | --help                     Help" << std::endl
+              << "               --config                   Scales to run (default regress/scales.json)" << std::endl
+              << "               --golden                   Directory of the golden results (default regress/golden)" << std::endl
+              << "               --work                     Directory for the generated datasets and outputs (default: system temp)" << std::endl
+              << "               --binary                   Program under test (default ./ams-BI)" << std::endl
+              << "               --generator                Dataset generator (default ./ams-gen)" << std::endl
+              << "               --filter                   Only run the scales whose name contains this text" << std::endl
+              << "               --repeat                   Runs per scale, the median wall time is kept (default 3)" << std::endl
+              << "               --report                   Write the measures to this JSON file" << std::endl
+              << "               --baseline                 Fail if slower or larger than this earlier report allows" << std::endl
+              << "               --update                   Replace the golden results with the outputs of this run" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    RegressOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help"))
+        {
+            print_usage();
+            return 0;
+        }
+        else if (!strcmp(argv[i], "--config") && hasValue)
+            options.configFile = argv[++i];
+        else if (!strcmp(argv[i], "--golden") && hasValue)
+            options.goldenRoot = argv[++i];
+        else if (!strcmp(argv[i], "--work") && hasValue)
+            options.workRoot = argv[++i];
+        else if (!strcmp(argv[i], "--binary") && hasValue)
+            options.binary = argv[++i];
+        else if (!strcmp(argv[i], "--generator") && hasValue)
+            options.generator = argv[++i];
+        else if (!strcmp(argv[i], "--filter") && hasValue)
+            options.filter = argv[++i];
+        else if (!strcmp(argv[i], "--repeat") && hasValue)
+            options.repeat = std::stoi(argv[++i]);
+        else if (!strcmp(argv[i], "--report") && hasValue)
+            options.reportFile = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && hasValue)
+            options.baselineFile = argv[++i];
+        else if (!strcmp(argv[i], "--update"))
+            options.update = true;
+        else if (!strcmp(argv[i], "--"))
+        {
+            options.extraArgs.assign(argv + i + 1, argv + argc);
+            break;
+        }
+        else
+        {
+            print_usage();
+            std::cerr << "Error: unknown or incomplete argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if (options.repeat < 1)
+    {
+        std::cerr << "Error: --repeat must be at least 1" << std::endl;
+        return 1;
+    }
+    return run_scales(options);
+}